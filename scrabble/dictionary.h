@@ -0,0 +1,770 @@
+/**
+ * Author : Samson Koshy
+ * Desc : the scrabble dictionary, a word graph built from the word list or mapped
+ *        from its compiled image, and the questions it answers
+ *
+ */
+
+#ifndef SCRABBLE_DICTIONARY_H
+#define SCRABBLE_DICTIONARY_H
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+class WordQuery;
+
+/**
+ * one state of the word graph
+ * bit i of letters is set when the state has an edge for 'A' + i, bit 26 when a word ends here.
+ * the states the edges lead to sit next to each other from child on, in letter order,
+ * so following an edge is a popcount and never a search
+ */
+typedef struct dNode { uint32_t letters; uint32_t child; } dawgNode;
+
+/**
+ * what precedes the states in the compiled image
+ * source is the size of the word list it was compiled from, so a changed list shows up as stale.
+ * the image is written in the byte order of the machine, a foreign one fails the version check
+ */
+typedef struct dHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t states;
+    uint64_t words;
+    uint64_t source;
+    uint64_t checksum;
+} dawgHeader;
+
+const char DAWGMAGIC[8] = {'S', 'O', 'W', 'D', 'A', 'W', 'G', '\0'};
+const uint32_t DAWGVERSION = 1;
+
+/**
+ * the dictionary as a minimized word graph (DAWG)
+ *
+ * the sorted word list is built into a trie one word at a time and every branch is
+ * minimized the moment the next word leaves it: a finished state is reduced to its
+ * row of edge targets, and rows that are already in the array are shared.
+ * state 0 is the root and is never the target of an edge, so 0 also means "no edge"
+ */
+class Dictionary {
+
+private:
+    // the states when the graph was built here, empty when it is mapped
+    std::vector<dawgNode> nodes;
+
+    // what the lookups read, either nodes or the mapped image
+    const dawgNode *graph;
+    size_t states;
+    size_t count;
+
+    void *image;
+    size_t imageBytes;
+
+    static const uint32_t END = 1u << 26;
+
+    /**
+     * a state whose edges are not all known yet
+     */
+    typedef struct pState { uint32_t letters; std::vector<dawgNode> children; } pendingState;
+
+    /**
+     * Helper Function
+     * turn a finished state into a graph state, sharing its row of edge targets
+     * with any state that has the same row
+     * @param p the finished state
+     * @param rows every row in the array so far, by content
+     * @return dawgNode
+     */
+    dawgNode freeze(const pendingState &p, std::unordered_map<std::string, uint32_t> &rows) {
+
+        dawgNode n = {p.letters, 0};
+        if ( p.children.empty() ) {
+            return n;
+        }
+
+        std::string key(reinterpret_cast<const char*>(p.children.data()), p.children.size() * sizeof(dawgNode));
+        auto it = rows.find(key);
+        if ( it != rows.end() ) {
+            n.child = it->second;
+        } else {
+            n.child = static_cast<uint32_t>(this->nodes.size());
+            this->nodes.insert(this->nodes.end(), p.children.begin(), p.children.end());
+            rows.emplace(std::make_pair(key, n.child));
+        }
+        return n;
+    }
+
+    /**
+     * Helper Function
+     * one multiply per state, cheap enough to run on every start
+     * @param n states
+     * @param size number of states
+     * @return uint64_t
+     */
+    static uint64_t checksum(const dawgNode *n, size_t size) {
+
+        uint64_t h = 14695981039346656037ull;
+        for ( size_t i = 0; i < size; ++i ) {
+            h = (h ^ ((static_cast<uint64_t>(n[i].letters) << 32) | n[i].child)) * 1099511628211ull;
+            h ^= h >> 29;
+        }
+        return h;
+    }
+
+    /**
+     * Helper Function
+     * let go of the mapped image, if any
+     */
+    void unmap() {
+
+        if ( this->image != nullptr ) {
+            munmap(this->image, this->imageBytes);
+            this->image = nullptr;
+            this->imageBytes = 0;
+        }
+    }
+
+public:
+
+    Dictionary() : graph(nullptr), states(0), count(0), image(nullptr), imageBytes(0) {}
+
+    Dictionary(const Dictionary &) = delete;
+    Dictionary &operator=(const Dictionary &) = delete;
+
+    ~Dictionary() {
+
+        this->unmap();
+    }
+
+    /**
+     * @param file
+     * @return uint64_t size of the file in bytes, 0 when it is not there
+     */
+    static uint64_t fileSize(const std::string &file) {
+
+        struct stat st;
+        if ( stat(file.c_str(), &st) != 0 ) {
+            return 0;
+        }
+        return static_cast<uint64_t>(st.st_size);
+    }
+
+    /**
+     * build the graph from a word list, one word per line
+     * @param file
+     * @return bool false when the file can not be read
+     */
+    bool load(const std::string &file) {
+
+        std::ifstream ifs;
+        std::string value;
+        std::vector<std::string> words;
+        ifs.open(file);
+        if (!ifs.is_open()) {
+            std::cout << "error opening file " << file << std::endl;
+            return false;
+        }
+        while (std::getline(ifs, value)) {
+            if (!value.empty() && value[value.size() - 1] == '\r')
+                value.erase(value.size() - 1);
+            if ( !value.empty() && std::all_of(value.begin(), value.end(), [](char c) { return c >= 'A' && c <= 'Z'; }) ) {
+                words.push_back(value);
+            }
+        }
+        ifs.close();
+
+        // the list ships sorted, only sort it when it is not
+        if ( !std::is_sorted(words.begin(), words.end()) ) {
+            std::sort(words.begin(), words.end());
+        }
+        words.erase(std::unique(words.begin(), words.end()), words.end());
+
+        this->build(words);
+        return true;
+    }
+
+    /**
+     * build the graph from sorted, unique words of the letters A-Z
+     * @param words
+     */
+    void build(const std::vector<std::string> &words) {
+
+        std::unordered_map<std::string, uint32_t> rows;
+        std::vector<pendingState> path(1);
+        std::string previous;
+
+        this->unmap();
+        this->nodes.assign(1, dawgNode{0, 0});
+        for ( const std::string &w : words ) {
+
+            // the part the word shares with the one before stays open, the rest is done
+            size_t common = 0;
+            while ( common < w.size() && common < previous.size() && w[common] == previous[common] ) {
+                ++common;
+            }
+            while ( path.size() > common + 1 ) {
+                dawgNode n = this->freeze(path.back(), rows);
+                path.pop_back();
+                path.back().children.push_back(n);
+            }
+
+            for ( size_t i = common; i < w.size(); ++i ) {
+                path.back().letters |= 1u << (w[i] - 'A');
+                path.push_back(pendingState());
+                path.back().letters = 0;
+            }
+            path.back().letters |= END;
+            previous = w;
+        }
+
+        while ( path.size() > 1 ) {
+            dawgNode n = this->freeze(path.back(), rows);
+            path.pop_back();
+            path.back().children.push_back(n);
+        }
+        this->nodes[0] = this->freeze(path[0], rows);
+        this->nodes.shrink_to_fit();
+        this->graph = this->nodes.data();
+        this->states = this->nodes.size();
+        this->count = words.size();
+    }
+
+    /**
+     * write the graph as an image that map() can use
+     * the image goes to a temporary name first and is renamed into place,
+     * so a process starting meanwhile never maps half a file
+     * @param file
+     * @param source size of the word list the graph was built from
+     * @return bool
+     */
+    bool save(const std::string &file, uint64_t source) const {
+
+        dawgHeader h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, DAWGMAGIC, sizeof(h.magic));
+        h.version = DAWGVERSION;
+        h.states = static_cast<uint32_t>(this->states);
+        h.words = this->count;
+        h.source = source;
+        h.checksum = checksum(this->graph, this->states);
+
+        std::string tmp = file + ".tmp";
+        std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+        ofs.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        ofs.write(reinterpret_cast<const char*>(this->graph), this->states * sizeof(dawgNode));
+        ofs.close();
+        if ( !ofs || std::rename(tmp.c_str(), file.c_str()) != 0 ) {
+            std::cout << "error writing file " << file << std::endl;
+            std::remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * map a compiled image read only, the pages are shared by every process that maps it
+     * @param file
+     * @param source size of the word list, 0 to skip the staleness check
+     * @return bool false when there is no usable image, the reason is printed unless it is missing
+     */
+    bool map(const std::string &file, uint64_t source) {
+
+        int fd = open(file.c_str(), O_RDONLY);
+        if ( fd < 0 ) {
+            return false;
+        }
+
+        struct stat st;
+        if ( fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(dawgHeader)) ) {
+            close(fd);
+            std::cout << "ignoring " << file << ": too short" << std::endl;
+            return false;
+        }
+
+        size_t bytes = static_cast<size_t>(st.st_size);
+        void *m = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if ( m == MAP_FAILED ) {
+            std::cout << "ignoring " << file << ": mmap failed" << std::endl;
+            return false;
+        }
+
+        const dawgHeader *h = static_cast<const dawgHeader*>(m);
+        const dawgNode *n = reinterpret_cast<const dawgNode*>(h + 1);
+        const char *why = nullptr;
+        if ( std::memcmp(h->magic, DAWGMAGIC, sizeof(h->magic)) != 0 ) {
+            why = "not a dictionary image";
+        } else if ( h->version != DAWGVERSION ) {
+            why = "version mismatch";
+        } else if ( h->states == 0 || bytes != sizeof(dawgHeader) + h->states * sizeof(dawgNode) ) {
+            why = "truncated";
+        } else if ( source != 0 && h->source != source ) {
+            why = "stale, the word list has changed";
+        } else if ( checksum(n, h->states) != h->checksum ) {
+            why = "checksum mismatch";
+        }
+        if ( why != nullptr ) {
+            munmap(m, bytes);
+            std::cout << "ignoring " << file << ": " << why << std::endl;
+            return false;
+        }
+
+        this->unmap();
+        this->nodes.clear();
+        this->nodes.shrink_to_fit();
+        this->image = m;
+        this->imageBytes = bytes;
+        this->graph = n;
+        this->states = h->states;
+        this->count = h->words;
+        return true;
+    }
+
+    /**
+     * read the graph from states that live somewhere else, inside another image for one,
+     * nothing is copied and the states have to outlive the dictionary
+     * @param n states, the root first
+     * @param size number of states
+     * @param words number of words
+     */
+    void view(const dawgNode *n, size_t size, size_t words) {
+
+        this->unmap();
+        this->nodes.clear();
+        this->nodes.shrink_to_fit();
+        this->graph = n;
+        this->states = size;
+        this->count = words;
+    }
+
+    /**
+     * @return const dawgNode* the states, to write them somewhere else
+     */
+    const dawgNode *data() const {
+        return this->graph;
+    }
+
+    /**
+     * @return bool whether the graph lives in a mapped image
+     */
+    bool mapped() const {
+        return this->image != nullptr;
+    }
+
+    /**
+     * @return uint32_t the state for the empty prefix
+     */
+    uint32_t root() const {
+        return 0;
+    }
+
+    /**
+     * follow the edge for a letter
+     * @param n state
+     * @param c letter A-Z
+     * @return uint32_t the next state, 0 when no word continues with c
+     */
+    uint32_t next(uint32_t n, char c) const {
+
+        const dawgNode &d = this->graph[n];
+        uint32_t bit = 1u << (c - 'A');
+        if ( !(d.letters & bit) ) {
+            return 0;
+        }
+        return d.child + __builtin_popcount(d.letters & (bit - 1));
+    }
+
+    /**
+     * @param n state
+     * @return bool whether the letters that lead to n make a word
+     */
+    bool isWord(uint32_t n) const {
+        return (this->graph[n].letters & END) != 0;
+    }
+
+    /**
+     * @param n state
+     * @return uint32_t bit i set when a word continues from n with 'A' + i
+     */
+    uint32_t edges(uint32_t n) const {
+        return this->graph[n].letters & (END - 1);
+    }
+
+    /**
+     * follow the letters of s from n
+     * @param n state, moved to the state after s
+     * @param s letters A-Z
+     * @return bool false when no word continues with s
+     */
+    bool walk(uint32_t &n, const std::string &s) const {
+
+        for ( char c : s ) {
+            if ( c < 'A' || c > 'Z' ) {
+                return false;
+            }
+            n = this->next(n, c);
+            if ( n == 0 ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @param word
+     * @return bool whether word is in the dictionary
+     */
+    bool contains(const std::string &word) const {
+
+        uint32_t n = this->root();
+        return this->walk(n, word) && this->isWord(n);
+    }
+
+    /**
+     * the letters that go in front of a word to make another
+     * @param word
+     * @return uint32_t bit i set when 'A' + i followed by word is a word
+     */
+    uint32_t frontHooks(const std::string &word) const {
+
+        uint32_t hooks = 0;
+        for ( uint32_t e = this->edges(this->root()); e != 0; e &= e - 1 ) {
+            uint32_t n = this->next(this->root(), static_cast<char>('A' + __builtin_ctz(e)));
+            if ( this->walk(n, word) && this->isWord(n) ) {
+                hooks |= e & -e;
+            }
+        }
+        return hooks;
+    }
+
+    /**
+     * the letters that go after a word to make another
+     * @param word
+     * @return uint32_t bit i set when word followed by 'A' + i is a word
+     */
+    uint32_t backHooks(const std::string &word) const {
+
+        uint32_t hooks = 0;
+        uint32_t n = this->root();
+        if ( !this->walk(n, word) ) {
+            return hooks;
+        }
+        for ( uint32_t e = this->edges(n); e != 0; e &= e - 1 ) {
+            if ( this->isWord(this->next(n, static_cast<char>('A' + __builtin_ctz(e)))) ) {
+                hooks |= e & -e;
+            }
+        }
+        return hooks;
+    }
+
+    /**
+     * the words that fit a pattern, a letter or ? for any letter in each place
+     * @param pattern e.g. ?A?E
+     * @return WordQuery
+     */
+    WordQuery pattern(const std::string &pattern) const;
+
+    /**
+     * the words that start with a prefix, which may hold ? for any letter
+     * @param prefix
+     * @return WordQuery
+     */
+    WordQuery prefix(const std::string &prefix) const;
+
+    /**
+     * the words that use every one of the tiles, ? or _ a blank for any letter
+     * @param tiles
+     * @return WordQuery
+     */
+    WordQuery anagram(const std::string &tiles) const;
+
+    /**
+     * @return size_t number of words
+     */
+    size_t words() const {
+        return this->count;
+    }
+
+    /**
+     * @return size_t number of states in the array
+     */
+    size_t size() const {
+        return this->states;
+    }
+
+    /**
+     * @return size_t bytes held by the array
+     */
+    size_t bytes() const {
+        return this->states * sizeof(dawgNode);
+    }
+};
+
+/**
+ * the words of the dictionary a query allows, walked out of the graph one at a time
+ *
+ * the walk is a depth first search held in an explicit stack, a frame for each letter with the
+ * edges from its state still to try, and the query masks those edges as each frame is pushed, so a
+ * branch no word of the query can be on is never entered. the iterator hands out the one word buffer
+ * the walk keeps, nothing is collected and nothing is allocated once the stack has grown to the
+ * longest word. words come in alphabetical order.
+ * an anagram spends a real tile before a blank on the same letter, so each word comes once
+ * however many ways the blanks could cover it.
+ * the query holds the walk, begin() starts it over and the iterators of one query share it
+ */
+class WordQuery {
+
+public:
+    enum kind { PATTERN, PREFIX, ANAGRAM };
+
+    class iterator {
+
+    private:
+        WordQuery *q;
+
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef std::string value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const std::string *pointer;
+        typedef const std::string &reference;
+
+        explicit iterator(WordQuery *q = nullptr) : q(q) {}
+
+        const std::string &operator*() const {
+            return this->q->word;
+        }
+
+        const std::string *operator->() const {
+            return &this->q->word;
+        }
+
+        iterator &operator++() {
+
+            if ( !this->q->advance() ) {
+                this->q = nullptr;
+            }
+            return *this;
+        }
+
+        bool operator==(const iterator &o) const {
+            return this->q == o.q;
+        }
+
+        bool operator!=(const iterator &o) const {
+            return this->q != o.q;
+        }
+    };
+
+private:
+    static const int BLANKS = 26;
+    static const uint32_t ALL = (1u << 26) - 1;
+
+    /**
+     * a letter of the walk: the state it leads to, the edges from there still to try
+     * and, for an anagram, whether a blank played it
+     */
+    typedef struct fData { uint32_t node; uint32_t left; bool blank; } frame;
+
+    const Dictionary *d;
+    kind k;
+    std::string letters;
+    bool valid;
+
+    // an anagram's tiles not yet used, blanks last, and the letters among them
+    int counts[27];
+    uint32_t have;
+    int remaining;
+
+    std::vector<frame> path;
+    std::string word;
+
+    /**
+     * Helper Function
+     * @return uint32_t the edges from the last state the query lets the walk take
+     */
+    uint32_t allowed() const {
+
+        uint32_t e = this->d->edges(this->path.back().node);
+        size_t depth = this->word.size();
+        switch ( this->k ) {
+            case PATTERN :
+            case PREFIX :
+                if ( depth < this->letters.size() ) {
+                    return e & ( this->letters[depth] == '?' ? ALL : 1u << (this->letters[depth] - 'A') );
+                }
+                return this->k == PREFIX ? e : 0;
+            case ANAGRAM :
+                return this->remaining == 0 ? 0 : e & ( this->counts[BLANKS] > 0 ? ALL : this->have );
+        }
+        return 0;
+    }
+
+    /**
+     * Helper Function
+     * @return bool whether the letters walked so far answer the query
+     */
+    bool accept() const {
+
+        if ( !this->d->isWord(this->path.back().node) ) {
+            return false;
+        }
+        switch ( this->k ) {
+            case PATTERN : return this->word.size() == this->letters.size();
+            case PREFIX : return this->word.size() >= this->letters.size();
+            case ANAGRAM : return this->remaining == 0;
+        }
+        return false;
+    }
+
+    /**
+     * Helper Function
+     * go back to the empty word with every tile in hand
+     */
+    void start() {
+
+        this->path.clear();
+        this->word.clear();
+        std::fill(this->counts, this->counts + 27, 0);
+        this->have = 0;
+        this->remaining = 0;
+        if ( !this->valid ) {
+            return;
+        }
+        if ( this->k == ANAGRAM ) {
+            for ( char c : this->letters ) {
+                int i = c == '?' ? BLANKS : c - 'A';
+                ++this->counts[i];
+                this->have |= i == BLANKS ? 0 : 1u << i;
+            }
+            this->remaining = static_cast<int>(this->letters.size());
+        }
+        this->path.push_back(frame{this->d->root(), 0, false});
+        this->path.back().left = this->allowed();
+    }
+
+    /**
+     * Helper Function
+     * walk on to the next word
+     * @return bool false when there are no more
+     */
+    bool advance() {
+
+        while ( !this->path.empty() ) {
+
+            frame &f = this->path.back();
+            if ( f.left == 0 ) {
+
+                // done with this letter, its tile goes back in hand
+                bool blank = f.blank;
+                this->path.pop_back();
+                if ( !this->path.empty() ) {
+                    int c = this->word.back() - 'A';
+                    if ( this->k == ANAGRAM ) {
+                        ++this->counts[blank ? BLANKS : c];
+                        this->have |= blank ? 0 : 1u << c;
+                        ++this->remaining;
+                    }
+                    this->word.pop_back();
+                }
+                continue;
+            }
+
+            int c = __builtin_ctz(f.left);
+            f.left &= f.left - 1;
+            uint32_t n = this->d->next(f.node, static_cast<char>('A' + c));
+
+            bool blank = false;
+            if ( this->k == ANAGRAM ) {
+                blank = this->counts[c] == 0;
+                if ( !blank && --this->counts[c] == 0 ) {
+                    this->have &= ~(1u << c);
+                }
+                this->counts[BLANKS] -= blank ? 1 : 0;
+                --this->remaining;
+            }
+            this->word += static_cast<char>('A' + c);
+            this->path.push_back(frame{n, 0, blank});
+            this->path.back().left = this->allowed();
+            if ( this->accept() ) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+
+    /**
+     * @param d
+     * @param k
+     * @param letters the pattern, the prefix or the tiles, lower case taken as upper case,
+     *                ? _ and . for any letter. anything else matches no word
+     */
+    WordQuery(const Dictionary &d, kind k, const std::string &letters) : d(&d), k(k), valid(true),
+                                                                          have(0), remaining(0) {
+
+        for ( char c : letters ) {
+            c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+            if ( c == '_' || c == '.' ) {
+                c = '?';
+            }
+            this->valid = this->valid && ( c == '?' || ( c >= 'A' && c <= 'Z' ) );
+            this->letters += c;
+        }
+        std::fill(this->counts, this->counts + 27, 0);
+    }
+
+    /**
+     * @return iterator at the first word, the walk starts over
+     */
+    iterator begin() {
+
+        this->start();
+        return iterator(this->advance() ? this : nullptr);
+    }
+
+    iterator end() {
+        return iterator();
+    }
+
+    /**
+     * @return size_t how many words, walking them all
+     */
+    size_t count() {
+
+        size_t n = 0;
+        for ( iterator it = this->begin(); it != this->end(); ++it ) {
+            ++n;
+        }
+        return n;
+    }
+};
+
+inline WordQuery Dictionary::pattern(const std::string &pattern) const {
+    return WordQuery(*this, WordQuery::PATTERN, pattern);
+}
+
+inline WordQuery Dictionary::prefix(const std::string &prefix) const {
+    return WordQuery(*this, WordQuery::PREFIX, prefix);
+}
+
+inline WordQuery Dictionary::anagram(const std::string &tiles) const {
+    return WordQuery(*this, WordQuery::ANAGRAM, tiles);
+}
+
+#endif // SCRABBLE_DICTIONARY_H
@@ -8,16 +8,38 @@
 #include <fstream>
 #include <set>
 #include <map>
+#include <mutex>
 #include <random>
 #include <string>
 #include <ctime>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <cmath>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "dictionary.h"
 
 
 /**
- *  1. load the sowpods into an ordered redblack tree std::set
+ *  1. load the sowpods into a directed acyclic word graph held in one flat array,
+ *     mapped straight from the compiled image when there is one (scrabble --compile), the anagram index likewise
  *  2. scrabble board 15x15 that will hold the letters
- *  3. mirror scrabble board that holds the points, so the points can be associated with the letters.
- *     for this iteration, there is only one double word in the center
+ *  3. mirror scrabble board that holds the premium squares, so the points can be associated with the letters.
+ *     the standard layout of double and triple letter and word squares, the centre is a double word
  *  4. hold the alphabets with points in an ordered map , alphabet is the key and the points is the value.
  *  4. get the picking of the letters to the rack working
  */
@@ -28,18 +50,1513 @@
 const int LEN = 15;
 const char BLANK = '_';
 const int RACKSIZE = 7;
+const int TILES = 100;
+const int BINGO = 50;
+
+/**
+ * the premium squares
+ * T triple word, D double word (* is the centre), t triple letter, d double letter
+ */
+const char PREMIUM[LEN][LEN + 1] = {
+        "T..d...T...d..T",
+        ".D...t...t...D.",
+        "..D...d.d...D..",
+        "d..D...d...D..d",
+        "....D.....D....",
+        ".t...t...t...t.",
+        "..d...d.d...d..",
+        "T..d...*...d..T",
+        "..d...d.d...d..",
+        ".t...t...t...t.",
+        "....D.....D....",
+        "d..D...d...D..d",
+        "..D...d.d...D..",
+        ".D...t...t...D.",
+        "T..d...T...d..T"
+};
+
+/**
+ * @param p a square of PREMIUM
+ * @return int what the square multiplies the letter on it by
+ */
+inline int letterMultiplier(char p) {
+    return p == 't' ? 3 : p == 'd' ? 2 : 1;
+}
+
+/**
+ * @param p a square of PREMIUM
+ * @return int what the square multiplies the word through it by
+ */
+inline int wordMultiplier(char p) {
+    return p == 'T' ? 3 : ( p == 'D' || p == '*' ) ? 2 : 1;
+}
+
+/**
+ * the word list and the images it compiles to
+ */
+const char* const WORDFILE = "SOWPODS_complete.txt";
+const char* const IMAGEFILE = "SOWPODS_complete.dawg";
+const char* const ANAGRAMFILE = "SOWPODS_complete.anagrams";
+
+/**
+ * the leave values --build-leaves writes and --leaves reads
+ */
+const char* const LEAVEFILE = "SOWPODS_complete.leaves";
 
 /**
  * represent the points as well as the quantity in alpha
  */
-typedef struct aData { int points; int quantity; } alphaData;
+typedef struct aData { int points; int quantity; } alphaData;
+
+/**
+ * the words of up to RACKSIZE letters grouped by their letters in sorted order (the signature),
+ * so the words a rack can make are found by looking up the sub-multisets of the rack
+ * instead of trying every arrangement of its tiles.
+ *
+ * words and signatures are packed 5 bits a letter ('A' is 1) into one 64 bit value,
+ * the groups sit in flat arrays and an open addressed table maps a signature to its group.
+ * the signatures themselves are also built into a word graph, the sub-multisets are walked
+ * through it in letter order so that a blank only ever tries the letters some signature
+ * continues with, and a dead prefix cuts off everything after it
+ *
+ * building all that walks the whole dictionary, so --compile writes it to an image of its own
+ * that is mapped at start up like the dictionary image, the arrays one after the other
+ */
+class AnagramIndex {
+
+private:
+    // the arrays when the index was built here, empty when it is mapped
+    std::vector<uint64_t> builtKeys;
+    std::vector<uint32_t> builtFirst;
+    std::vector<uint64_t> builtWords;
+    std::vector<uint32_t> builtTable;
+
+    // what the lookups read, either the arrays above or the mapped image
+    const uint64_t *keys;     // signature of each group
+    const uint32_t *first;    // words of group g are words[first[g] .. first[g + 1])
+    const uint64_t *words;
+    const uint32_t *table;    // group + 1, 0 for an empty slot
+    size_t groupCount;
+    size_t wordCount;
+    size_t slots;
+    Dictionary signatures;
+    int shift;
+    int maxLen;
+
+    void *image;
+    size_t imageBytes;
+
+    /**
+     * what precedes the arrays in the image, source as in the dictionary image
+     */
+    typedef struct aHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t maxLen;
+        uint32_t groups;
+        uint32_t words;
+        uint32_t slots;
+        uint32_t states;
+        uint64_t source;
+        uint64_t checksum;
+    } anagramHeader;
+
+    static const uint32_t VERSION = 1;
+
+    /**
+     * Helper Function
+     * @param h header of the image, the arrays follow it
+     * @return size_t bytes of the arrays
+     */
+    static size_t payload(const anagramHeader &h) {
+        return (size_t(h.groups) + h.words) * sizeof(uint64_t) + (size_t(h.groups) + 1 + h.slots) * sizeof(uint32_t) +
+               size_t(h.states) * sizeof(dawgNode);
+    }
+
+    /**
+     * Helper Function
+     * @param p the arrays
+     * @param bytes their size, a multiple of 4
+     * @return uint64_t
+     */
+    static uint64_t checksum(const void *p, size_t bytes) {
+
+        const uint32_t *w = static_cast<const uint32_t*>(p);
+        uint64_t h = 14695981039346656037ull;
+        for ( size_t i = 0; i < bytes / sizeof(uint32_t); ++i ) {
+            h = (h ^ w[i]) * 1099511628211ull;
+            h ^= h >> 29;
+        }
+        return h;
+    }
+
+    /**
+     * Helper Function
+     * let go of the mapped image, if any
+     */
+    void unmap() {
+
+        if ( this->image != nullptr ) {
+            munmap(this->image, this->imageBytes);
+            this->image = nullptr;
+            this->imageBytes = 0;
+        }
+    }
+
+    /**
+     * Helper Function
+     * @param key signature
+     * @return uint32_t the first slot to probe
+     */
+    uint32_t slot(uint64_t key) const {
+        return static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ull) >> this->shift);
+    }
+
+    /**
+     * Helper Function
+     * collect the words below a state
+     * @param d dictionary
+     * @param n state
+     * @param word letters so far, packed
+     * @param len number of letters so far
+     * @param out word and signature pairs
+     */
+    void collect(const Dictionary &d, uint32_t n, uint64_t word, int len, std::vector<std::pair<uint64_t, uint64_t>> &out) {
+
+        if ( len >= 2 && d.isWord(n) ) {
+            out.push_back(std::make_pair(signature(word, len), word));
+        }
+        if ( len == this->maxLen ) {
+            return;
+        }
+        for ( uint32_t e = d.edges(n); e != 0; e &= e - 1 ) {
+            char c = static_cast<char>('A' + __builtin_ctz(e));
+            this->collect(d, d.next(n, c), (word << 5) | static_cast<uint64_t>(c - 'A' + 1), len + 1, out);
+        }
+    }
+
+    /**
+     * Helper Function
+     * grow the signature by one tile, real or blank, of a letter no lower than the last one
+     * copies of a letter come real first and blank after, so every cover is walked once
+     * @param n state of the signature graph
+     * @param low lowest letter the next tile may be
+     * @param blankRun whether the last tile was a blank standing for low
+     * @param key signature so far
+     * @param len its length
+     * @param blanks blanks left
+     * @param counts real tiles of each letter left
+     * @param have bit c set while counts[c] > 0
+     * @param blankUse letters the blanks stand for so far
+     * @param emit called with each packed word, its length and blankUse
+     */
+    template<typename F>
+    void search(uint32_t n, int low, bool blankRun, uint64_t key, int len, int blanks,
+                int *counts, uint32_t have, int *blankUse, F &emit) const {
+
+        if ( len >= 2 && this->signatures.isWord(n) ) {
+            int g = this->find(key);
+            for ( uint32_t i = this->first[g]; i < this->first[g + 1]; ++i ) {
+                emit(this->words[i], len, blankUse);
+            }
+        }
+        if ( len == this->maxLen ) {
+            return;
+        }
+
+        // without blanks only the letters still on the rack can follow
+        uint32_t e = this->signatures.edges(n) & ~((1u << low) - 1);
+        if ( blanks == 0 ) {
+            e &= have;
+        }
+        for ( ; e != 0; e &= e - 1 ) {
+
+            int c = __builtin_ctz(e);
+            uint32_t m = this->signatures.next(n, static_cast<char>('A' + c));
+            uint64_t k = (key << 5) | static_cast<uint64_t>(c + 1);
+            if ( counts[c] > 0 && !( blankRun && c == low ) ) {
+                --counts[c];
+                this->search(m, c, false, k, len + 1, blanks, counts, counts[c] > 0 ? have : have & ~(1u << c), blankUse, emit);
+                ++counts[c];
+            }
+            if ( blanks > 0 ) {
+                ++blankUse[c];
+                this->search(m, c, true, k, len + 1, blanks - 1, counts, have, blankUse, emit);
+                --blankUse[c];
+            }
+        }
+    }
+
+public:
+
+    AnagramIndex() : keys(nullptr), first(nullptr), words(nullptr), table(nullptr), groupCount(0), wordCount(0),
+                     slots(0), shift(64), maxLen(0), image(nullptr), imageBytes(0) {}
+
+    ~AnagramIndex() {
+
+        // the signature graph may point into the image
+        this->signatures.view(nullptr, 0, 0);
+        this->unmap();
+    }
+
+    /**
+     * Helper Function
+     * @param word packed word
+     * @param len its length
+     * @return uint64_t the letters of word in sorted order, packed
+     */
+    static uint64_t signature(uint64_t word, int len) {
+
+        int letters[RACKSIZE * 3];
+        for ( int i = 0; i < len; ++i ) {
+            letters[i] = static_cast<int>(word & 31);
+            word >>= 5;
+        }
+        std::sort(letters, letters + len);
+
+        uint64_t key = 0;
+        for ( int i = 0; i < len; ++i ) {
+            key = (key << 5) | static_cast<uint64_t>(letters[i]);
+        }
+        return key;
+    }
+
+    /**
+     * Helper Function
+     * @param word packed word
+     * @param len its length
+     * @param out len letters, not terminated
+     */
+    static void unpack(uint64_t word, int len, char *out) {
+
+        for ( int i = len - 1; i >= 0; --i ) {
+            out[i] = static_cast<char>('A' - 1 + (word & 31));
+            word >>= 5;
+        }
+    }
+
+    /**
+     * index the words of 2 to maxLen letters
+     * @param d dictionary
+     * @param maxLen at most RACKSIZE
+     */
+    void build(const Dictionary &d, int maxLen) {
+
+        this->maxLen = std::min(maxLen, RACKSIZE);
+
+        std::vector<std::pair<uint64_t, uint64_t>> all;
+        this->collect(d, d.root(), 0, 0, all);
+        std::sort(all.begin(), all.end());
+
+        std::vector<uint64_t> &keys = this->builtKeys;
+        keys.clear();
+        this->builtFirst.clear();
+        this->builtWords.clear();
+        this->builtWords.reserve(all.size());
+        for ( size_t i = 0; i < all.size(); ++i ) {
+            if ( i == 0 || all[i].first != all[i - 1].first ) {
+                keys.push_back(all[i].first);
+                this->builtFirst.push_back(static_cast<uint32_t>(this->builtWords.size()));
+            }
+            this->builtWords.push_back(all[i].second);
+        }
+        this->builtFirst.push_back(static_cast<uint32_t>(this->builtWords.size()));
+
+        std::vector<std::string> sorted(keys.size());
+        for ( size_t g = 0; g < keys.size(); ++g ) {
+            int len = 0;
+            for ( uint64_t k = keys[g]; k != 0; k >>= 5 ) {
+                ++len;
+            }
+            sorted[g].resize(len);
+            unpack(keys[g], len, &sorted[g][0]);
+        }
+        std::sort(sorted.begin(), sorted.end());
+        this->signatures.build(sorted);
+        this->unmap();
+
+        // at most half full
+        size_t slots = 1;
+        this->shift = 64;
+        while ( slots < 2 * keys.size() ) {
+            slots <<= 1;
+            --this->shift;
+        }
+        this->builtTable.assign(slots, 0);
+        for ( size_t g = 0; g < keys.size(); ++g ) {
+            uint32_t h = this->slot(keys[g]);
+            while ( this->builtTable[h] != 0 ) {
+                h = (h + 1) & (slots - 1);
+            }
+            this->builtTable[h] = static_cast<uint32_t>(g + 1);
+        }
+
+        this->keys = keys.data();
+        this->first = this->builtFirst.data();
+        this->words = this->builtWords.data();
+        this->table = this->builtTable.data();
+        this->groupCount = keys.size();
+        this->wordCount = this->builtWords.size();
+        this->slots = slots;
+    }
+
+    /**
+     * write the index as an image that map() can use, through a temporary name like the dictionary image
+     * @param file
+     * @param source size of the word list the index was built from
+     * @return bool
+     */
+    bool save(const std::string &file, uint64_t source) const {
+
+        anagramHeader h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, "SOWANAG", 8);
+        h.version = VERSION;
+        h.maxLen = static_cast<uint32_t>(this->maxLen);
+        h.groups = static_cast<uint32_t>(this->groupCount);
+        h.words = static_cast<uint32_t>(this->wordCount);
+        h.slots = static_cast<uint32_t>(this->slots);
+        h.states = static_cast<uint32_t>(this->signatures.size());
+        h.source = source;
+
+        std::string arrays;
+        arrays.append(reinterpret_cast<const char*>(this->keys), this->groupCount * sizeof(uint64_t));
+        arrays.append(reinterpret_cast<const char*>(this->words), this->wordCount * sizeof(uint64_t));
+        arrays.append(reinterpret_cast<const char*>(this->first), (this->groupCount + 1) * sizeof(uint32_t));
+        arrays.append(reinterpret_cast<const char*>(this->table), this->slots * sizeof(uint32_t));
+        arrays.append(reinterpret_cast<const char*>(this->signatures.data()), this->signatures.bytes());
+        h.checksum = checksum(arrays.data(), arrays.size());
+
+        std::string tmp = file + ".tmp";
+        std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+        ofs.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        ofs.write(arrays.data(), arrays.size());
+        ofs.close();
+        if ( !ofs || std::rename(tmp.c_str(), file.c_str()) != 0 ) {
+            std::cout << "error writing file " << file << std::endl;
+            std::remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * map a compiled index read only
+     * @param file
+     * @param source size of the word list, 0 to skip the staleness check
+     * @param maxLen the longest words the index has to hold
+     * @return bool false when there is no usable image, the reason is printed unless it is missing
+     */
+    bool map(const std::string &file, uint64_t source, int maxLen) {
+
+        int fd = open(file.c_str(), O_RDONLY);
+        if ( fd < 0 ) {
+            return false;
+        }
+
+        struct stat st;
+        if ( fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(anagramHeader)) ) {
+            close(fd);
+            std::cout << "ignoring " << file << ": too short" << std::endl;
+            return false;
+        }
+
+        size_t bytes = static_cast<size_t>(st.st_size);
+        void *m = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if ( m == MAP_FAILED ) {
+            std::cout << "ignoring " << file << ": mmap failed" << std::endl;
+            return false;
+        }
+
+        const anagramHeader *h = static_cast<const anagramHeader*>(m);
+        const char *why = nullptr;
+        if ( std::memcmp(h->magic, "SOWANAG", 8) != 0 ) {
+            why = "not an anagram image";
+        } else if ( h->version != VERSION || h->maxLen != static_cast<uint32_t>(std::min(maxLen, RACKSIZE)) ) {
+            why = "version mismatch";
+        } else if ( h->states == 0 || h->slots == 0 || ( h->slots & (h->slots - 1) ) != 0 ||
+                    bytes != sizeof(anagramHeader) + payload(*h) ) {
+            why = "truncated";
+        } else if ( source != 0 && h->source != source ) {
+            why = "stale, the word list has changed";
+        } else if ( checksum(h + 1, payload(*h)) != h->checksum ) {
+            why = "checksum mismatch";
+        }
+        if ( why != nullptr ) {
+            munmap(m, bytes);
+            std::cout << "ignoring " << file << ": " << why << std::endl;
+            return false;
+        }
+
+        this->signatures.view(nullptr, 0, 0);
+        this->unmap();
+        this->builtKeys.clear();
+        this->builtFirst.clear();
+        this->builtWords.clear();
+        this->builtTable.clear();
+        this->image = m;
+        this->imageBytes = bytes;
+
+        const char *at = reinterpret_cast<const char*>(h + 1);
+        this->keys = reinterpret_cast<const uint64_t*>(at);
+        at += h->groups * sizeof(uint64_t);
+        this->words = reinterpret_cast<const uint64_t*>(at);
+        at += h->words * sizeof(uint64_t);
+        this->first = reinterpret_cast<const uint32_t*>(at);
+        at += (h->groups + 1) * sizeof(uint32_t);
+        this->table = reinterpret_cast<const uint32_t*>(at);
+        at += h->slots * sizeof(uint32_t);
+        this->signatures.view(reinterpret_cast<const dawgNode*>(at), h->states, h->groups);
+
+        this->maxLen = static_cast<int>(h->maxLen);
+        this->groupCount = h->groups;
+        this->wordCount = h->words;
+        this->slots = h->slots;
+        this->shift = 64 - __builtin_ctzll(h->slots);
+        return true;
+    }
+
+    /**
+     * @return bool whether the index lives in a mapped image
+     */
+    bool mapped() const {
+        return this->image != nullptr;
+    }
+
+    /**
+     * @param key signature
+     * @return int the group of words with that signature, -1 when there is none
+     */
+    int find(uint64_t key) const {
+
+        if ( this->slots == 0 ) {
+            return -1;
+        }
+        uint32_t mask = static_cast<uint32_t>(this->slots - 1);
+        for ( uint32_t h = this->slot(key); this->table[h] != 0; h = (h + 1) & mask ) {
+            if ( this->keys[this->table[h] - 1] == key ) {
+                return static_cast<int>(this->table[h] - 1);
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * every word a rack can make, once for each way of covering its letters with real tiles and blanks
+     * @param rack letters A-Z and BLANK
+     * @param emit called as emit(uint64_t packed word, int length, const int blankUse[26])
+     */
+    template<typename F>
+    void anagrams(const std::string &rack, F emit) const {
+
+        int counts[26] = {0};
+        int blankUse[26] = {0};
+        int blanks = 0;
+        uint32_t have = 0;
+        for ( char c : rack ) {
+            if ( c == BLANK ) {
+                ++blanks;
+            } else if ( c >= 'A' && c <= 'Z' ) {
+                ++counts[c - 'A'];
+                have |= 1u << (c - 'A');
+            }
+        }
+        if ( this->signatures.size() != 0 ) {
+            this->search(this->signatures.root(), 0, false, 0, 0, blanks, counts, have, blankUse, emit);
+        }
+    }
+
+    /**
+     * @return size_t number of words indexed
+     */
+    size_t size() const {
+        return this->wordCount;
+    }
+
+    /**
+     * @return size_t number of signatures
+     */
+    size_t groups() const {
+        return this->groupCount;
+    }
+};
+
+/**
+ * a move as the generator finds it
+ * word holds the whole word, the tiles already on the board included, a blank played is lower case.
+ * bit i of placed is set when word[i] comes from the rack
+ * score is the sum of the breakdown: the word itself, the cross words it makes and the bingo.
+ * leave is what the tiles kept on the rack are worth, 0 until a leave table is asked
+ */
+typedef struct mData {
+    int row;
+    int col;
+    bool across;
+    int length;
+    char word[LEN + 1];
+    uint16_t placed;
+    int score;
+    int mainScore;
+    int crossScore;
+    int bingo;
+    float leave;
+} move;
+
+/**
+ * every legal move for a rack on a board
+ *
+ * the board is turned so the moves run across, once as it is and once transposed.
+ * for each square the generator works out whether it is an anchor (an empty square next to a tile,
+ * or the centre of an empty board) and which letters fit the word running down through it (the cross check).
+ * from each anchor it grows the part of the word left of it, either the tiles already there or rack tiles
+ * over the empty squares back to the previous anchor, and extends it right through the word graph,
+ * so a letter is only ever tried when some word still continues with it
+ *
+ * an empty board has nothing to hook onto, the opening moves are the anagrams of the rack
+ * laid across the centre, so they come straight from the anagram index. only the across
+ * moves of an opening are reported, the down ones are the same moves transposed
+ *
+ * the generator keeps its state for one call at a time, use one per thread
+ */
+class MoveGenerator {
+
+private:
+    const Dictionary &dict;
+    const AnagramIndex &index;
+    int points[26];
+
+    static const uint32_t ALL = (1u << 26) - 1;
+
+    // the board turned so that the moves run across
+    char g[LEN][LEN];
+    uint32_t cross[LEN][LEN];
+    bool crossWord[LEN][LEN];
+    bool anchor[LEN][LEN];
+
+    // premiums of the turned board, and the points of the tiles above and below each empty square
+    int letterMul[LEN][LEN];
+    int wordMul[LEN][LEN];
+    int crossSum[LEN][LEN];
+
+    // tiles left, 26 is the blank
+    int rack[27];
+    int tiles;
+
+    // the move being built
+    bool across;
+    int row;
+    int anchorCol;
+    char word[LEN + 1];
+    uint16_t placed;
+
+    /**
+     * Helper Function
+     * @param c a tile on the board
+     * @return char the letter, upper case
+     */
+    static char letter(char c) {
+        return static_cast<char>(c >= 'a' ? c - 'a' + 'A' : c);
+    }
+
+    /**
+     * Helper Function
+     * @param c a tile
+     * @return int its points, nothing for a blank
+     */
+    int value(char c) const {
+        return c >= 'A' && c <= 'Z' ? this->points[c - 'A'] : 0;
+    }
+
+    /**
+     * Helper Function
+     * work out the anchors, cross checks and cross scores of the turned board
+     */
+    void prepare() {
+
+        for ( int r = 0; r < LEN; ++r ) {
+            for ( int c = 0; c < LEN; ++c ) {
+
+                char p = this->across ? PREMIUM[r][c] : PREMIUM[c][r];
+                this->letterMul[r][c] = letterMultiplier(p);
+                this->wordMul[r][c] = wordMultiplier(p);
+                this->crossSum[r][c] = 0;
+
+                this->anchor[r][c] = false;
+                this->crossWord[r][c] = false;
+                this->cross[r][c] = ALL;
+                if ( this->g[r][c] ) {
+                    this->cross[r][c] = 0;
+                    continue;
+                }
+
+                bool up = r > 0 && this->g[r - 1][c];
+                bool down = r < LEN - 1 && this->g[r + 1][c];
+                bool left = c > 0 && this->g[r][c - 1];
+                bool right = c < LEN - 1 && this->g[r][c + 1];
+                this->anchor[r][c] = up || down || left || right;
+                if ( !up && !down ) {
+                    continue;
+                }
+
+                // the letters that make a word of the tiles above, the square and the tiles below
+                this->crossWord[r][c] = true;
+                this->cross[r][c] = 0;
+                int top = r;
+                while ( top > 0 && this->g[top - 1][c] ) {
+                    --top;
+                }
+                for ( int i = top; i < LEN && ( i == r || this->g[i][c] ); ++i ) {
+                    this->crossSum[r][c] += this->value(this->g[i][c]);
+                }
+                // next() never leads back to the root, so 0 after a step means no word goes on
+                uint32_t n = this->dict.root();
+                bool dead = false;
+                for ( int i = top; i < r && !dead; ++i ) {
+                    n = this->dict.next(n, letter(this->g[i][c]));
+                    dead = n == 0;
+                }
+                if ( dead ) {
+                    continue;
+                }
+                for ( uint32_t e = this->dict.edges(n); e != 0; e &= e - 1 ) {
+                    int l = __builtin_ctz(e);
+                    uint32_t m = this->dict.next(n, static_cast<char>('A' + l));
+                    for ( int i = r + 1; i < LEN && this->g[i][c] && m != 0; ++i ) {
+                        m = this->dict.next(m, letter(this->g[i][c]));
+                    }
+                    if ( m != 0 && this->dict.isWord(m) ) {
+                        this->cross[r][c] |= 1u << l;
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * Helper Function
+     * hand the move in word[0 .. length) to emit
+     * @param start column of its first letter
+     * @param length
+     * @param sum letter points of the main word, letter premiums applied
+     * @param mult word premiums of the main word
+     * @param crossTotal points of the cross words
+     * @param emit
+     */
+    template<typename F>
+    void record(int start, int length, int sum, int mult, int crossTotal, F &emit) {
+
+        // a single tile with a word running across through it was already found across
+        if ( !this->across && __builtin_popcount(this->placed) == 1 &&
+             this->crossWord[this->row][start + __builtin_ctz(this->placed)] ) {
+            return;
+        }
+
+        move m;
+        m.across = this->across;
+        m.row = this->across ? this->row : start;
+        m.col = this->across ? start : this->row;
+        m.length = length;
+        std::memcpy(m.word, this->word, length);
+        m.word[length] = '\0';
+        m.placed = this->placed;
+        m.mainScore = sum * mult;
+        m.crossScore = crossTotal;
+        m.bingo = __builtin_popcount(this->placed) == RACKSIZE ? BINGO : 0;
+        m.score = m.mainScore + m.crossScore + m.bingo;
+        m.leave = 0;
+        emit(m);
+    }
+
+    /**
+     * Helper Function
+     * lay a tile for letter l at word[i], a real one and then a blank, and go on with next
+     * @param l letter 0-25
+     * @param i position in the word
+     * @param go what to do with the tile in place, called with the points of the tile
+     */
+    template<typename G>
+    void layTile(int l, int i, G go) {
+
+        uint16_t bit = static_cast<uint16_t>(1u << i);
+        if ( this->rack[l] > 0 ) {
+            --this->rack[l];
+            this->word[i] = static_cast<char>('A' + l);
+            this->placed |= bit;
+            go(this->points[l]);
+            this->placed &= ~bit;
+            ++this->rack[l];
+        }
+        if ( this->rack[26] > 0 ) {
+            --this->rack[26];
+            this->word[i] = static_cast<char>('a' + l);
+            this->placed |= bit;
+            go(0);
+            this->placed &= ~bit;
+            ++this->rack[26];
+        }
+    }
+
+    /**
+     * Helper Function
+     * extend the word to the right through the square pos, scoring as it goes
+     * @param n state for word[0 .. pos - start)
+     * @param pos column
+     * @param start column of the first letter
+     * @param sum letter points of word[0 .. pos - start), letter premiums applied
+     * @param mult word premiums so far
+     * @param crossTotal points of the cross words so far
+     * @param emit
+     */
+    template<typename F>
+    void extendRight(uint32_t n, int pos, int start, int sum, int mult, int crossTotal, F &emit) {
+
+        if ( pos < LEN && this->g[this->row][pos] ) {
+            char c = this->g[this->row][pos];
+            uint32_t m = this->dict.next(n, letter(c));
+            if ( m != 0 ) {
+                this->word[pos - start] = c;
+                this->extendRight(m, pos + 1, start, sum + this->value(c), mult, crossTotal, emit);
+            }
+            return;
+        }
+
+        if ( pos > this->anchorCol && this->dict.isWord(n) ) {
+            this->record(start, pos - start, sum, mult, crossTotal, emit);
+        }
+        if ( pos == LEN ) {
+            return;
+        }
+
+        int lm = this->letterMul[this->row][pos];
+        int wm = this->wordMul[this->row][pos];
+        bool crossing = this->crossWord[this->row][pos];
+        int crossBase = this->crossSum[this->row][pos];
+        for ( uint32_t e = this->dict.edges(n) & this->cross[this->row][pos]; e != 0; e &= e - 1 ) {
+            int l = __builtin_ctz(e);
+            uint32_t m = this->dict.next(n, static_cast<char>('A' + l));
+            this->layTile(l, pos - start, [&](int v) {
+                this->extendRight(m, pos + 1, start, sum + v * lm, mult * wm,
+                                  crossing ? crossTotal + (crossBase + v * lm) * wm : crossTotal, emit);
+            });
+        }
+    }
+
+    /**
+     * Helper Function
+     * every left part of up to limit rack tiles ending just before the anchor, each extended right
+     * @param n state for word[0 .. len)
+     * @param len tiles in the left part
+     * @param limit empty squares free to the left of the anchor
+     * @param emit
+     */
+    template<typename F>
+    void leftPart(uint32_t n, int len, int limit, F &emit) {
+
+        // the left part only lands on its squares once it stops growing, score it here
+        int start = this->anchorCol - len;
+        int sum = 0, mult = 1;
+        for ( int i = 0; i < len; ++i ) {
+            sum += this->value(this->word[i]) * this->letterMul[this->row][start + i];
+            mult *= this->wordMul[this->row][start + i];
+        }
+        this->extendRight(n, this->anchorCol, start, sum, mult, 0, emit);
+        if ( len == limit ) {
+            return;
+        }
+
+        // the squares left of an anchor up to the previous one touch no tile, every letter fits them
+        for ( uint32_t e = this->dict.edges(n); e != 0; e &= e - 1 ) {
+            int l = __builtin_ctz(e);
+            uint32_t m = this->dict.next(n, static_cast<char>('A' + l));
+            this->layTile(l, len, [&](int) { this->leftPart(m, len + 1, limit, emit); });
+        }
+    }
+
+    /**
+     * Helper Function
+     * every move through the anchor at col of the current row
+     * @param col
+     * @param emit
+     */
+    template<typename F>
+    void fromAnchor(int col, F &emit) {
+
+        this->anchorCol = col;
+        this->placed = 0;
+        const char *line = this->g[this->row];
+
+        // tiles right before the anchor are the left part
+        if ( col > 0 && line[col - 1] ) {
+            int start = col - 1;
+            while ( start > 0 && line[start - 1] ) {
+                --start;
+            }
+            uint32_t n = this->dict.root();
+            int sum = 0;
+            for ( int i = start; i < col; ++i ) {
+                n = this->dict.next(n, letter(line[i]));
+                if ( n == 0 ) {
+                    return;
+                }
+                this->word[i - start] = line[i];
+                sum += this->value(line[i]);
+            }
+            this->extendRight(n, col, start, sum, 1, 0, emit);
+            return;
+        }
+
+        int limit = 0;
+        for ( int p = col - 1; p >= 0 && !line[p] && !this->anchor[this->row][p] && limit < this->tiles - 1; --p ) {
+            ++limit;
+        }
+        this->leftPart(this->dict.root(), 0, limit, emit);
+    }
+
+    /**
+     * Helper Function
+     * decide which letters of an opening word the blanks stand for, then lay it across the centre
+     * at every column that covers it
+     * @param m the word, upper case so far
+     * @param i position to decide
+     * @param left blanks still to place, by letter
+     * @param after letters of the word from i on
+     * @param emit
+     */
+    template<typename F>
+    void opening(move &m, int i, int *left, int *after, F &emit) {
+
+        if ( i == m.length ) {
+            const int r = LEN / 2;
+            for ( int start = std::max(0, r - m.length + 1); start <= r && start + m.length <= LEN; ++start ) {
+                int sum = 0, mult = 1;
+                for ( int j = 0; j < m.length; ++j ) {
+                    sum += this->value(m.word[j]) * letterMultiplier(PREMIUM[r][start + j]);
+                    mult *= wordMultiplier(PREMIUM[r][start + j]);
+                }
+                m.col = start;
+                m.mainScore = sum * mult;
+                m.crossScore = 0;
+                m.bingo = m.length == RACKSIZE ? BINGO : 0;
+                m.score = m.mainScore + m.bingo;
+                m.leave = 0;
+                emit(static_cast<const move &>(m));
+            }
+            return;
+        }
+
+        int c = m.word[i] - 'A';
+        --after[c];
+        if ( left[c] > 0 ) {
+            --left[c];
+            m.word[i] = static_cast<char>('a' + c);
+            this->opening(m, i + 1, left, after, emit);
+            m.word[i] = static_cast<char>('A' + c);
+            ++left[c];
+        }
+        if ( left[c] <= after[c] ) {
+            this->opening(m, i + 1, left, after, emit);
+        }
+        ++after[c];
+    }
+
+    /**
+     * Helper Function
+     * every opening move, from the anagrams of the rack
+     * @param letters the rack
+     * @param emit
+     */
+    template<typename F>
+    void openings(const std::string &letters, F &emit) {
+
+        this->index.anagrams(letters, [&](uint64_t packed, int len, const int *blankUse) {
+
+            move m;
+            m.across = true;
+            m.row = LEN / 2;
+            m.length = len;
+            AnagramIndex::unpack(packed, len, m.word);
+            m.word[len] = '\0';
+            m.placed = static_cast<uint16_t>((1u << len) - 1);
+
+            int left[26], after[26] = {0};
+            std::copy(blankUse, blankUse + 26, left);
+            for ( int i = 0; i < len; ++i ) {
+                ++after[m.word[i] - 'A'];
+            }
+            this->opening(m, 0, left, after, emit);
+        });
+    }
+
+public:
+
+    /**
+     * @param d dictionary
+     * @param a anagram index of d, for the openings
+     * @param alpha points of each letter
+     */
+    MoveGenerator(const Dictionary &d, const AnagramIndex &a, const std::map<char, alphaData> &alpha) :
+            dict(d), index(a), tiles(0), across(true), row(0), anchorCol(0), placed(0) {
+
+        for ( int l = 0; l < 26; ++l ) {
+            this->points[l] = alpha.find(static_cast<char>('A' + l))->second.points;
+        }
+    }
+
+    /**
+     * find every legal move
+     * @param b the board, '\0' for an empty square, upper case for a tile, lower case for a blank
+     * @param letters the rack, A-Z and BLANK
+     * @param emit called with each move as emit(const move &)
+     */
+    template<typename F>
+    void generate(const char (&b)[LEN][LEN], const std::string &letters, F emit) {
+
+        this->generate(b, letters.data(), static_cast<int>(letters.size()), emit);
+    }
+
+    /**
+     * find every legal move, for callers that keep the rack in a buffer of their own
+     * only an empty board builds a string, any other position allocates nothing
+     * @param b the board
+     * @param letters the rack, A-Z and BLANK
+     * @param count number of tiles in letters
+     * @param emit called with each move as emit(const move &)
+     */
+    template<typename F>
+    void generate(const char (&b)[LEN][LEN], const char *letters, int count, F emit) {
+
+        std::fill(this->rack, this->rack + 27, 0);
+        this->tiles = 0;
+        for ( int i = 0; i < count; ++i ) {
+            char c = letters[i];
+            if ( c == BLANK ) {
+                ++this->rack[26];
+            } else if ( c >= 'A' && c <= 'Z' ) {
+                ++this->rack[c - 'A'];
+            } else {
+                continue;
+            }
+            ++this->tiles;
+        }
+
+        bool empty = true;
+        for ( int r = 0; r < LEN && empty; ++r ) {
+            for ( int c = 0; c < LEN && empty; ++c ) {
+                empty = b[r][c] == '\0';
+            }
+        }
+        if ( empty ) {
+            this->openings(std::string(letters, count), emit);
+            return;
+        }
+
+        for ( int o = 0; o < 2; ++o ) {
+
+            this->across = o == 0;
+            for ( int r = 0; r < LEN; ++r ) {
+                for ( int c = 0; c < LEN; ++c ) {
+                    this->g[r][c] = this->across ? b[r][c] : b[c][r];
+                }
+            }
+            this->prepare();
+
+            for ( this->row = 0; this->row < LEN; ++this->row ) {
+                for ( int c = 0; c < LEN; ++c ) {
+                    if ( this->anchor[this->row][c] ) {
+                        this->fromAnchor(c, emit);
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * score a move from scratch: the main word with the premiums under the new tiles,
+     * every cross word a new tile makes, and the bingo
+     * the generator gets the same number incrementally, this is the reference
+     * @param b the board before the move
+     * @param m
+     * @return int
+     */
+    int score(const char (&b)[LEN][LEN], const move &m) const {
+
+        int dr = m.across ? 0 : 1, dc = m.across ? 1 : 0;
+        int sum = 0, mult = 1, crossTotal = 0;
+        for ( int i = 0; i < m.length; ++i ) {
+
+            int r = m.row + dr * i, c = m.col + dc * i;
+            if ( !(m.placed & (1u << i)) ) {
+                sum += this->value(b[r][c]);
+                continue;
+            }
+
+            int lm = letterMultiplier(PREMIUM[r][c]);
+            int wm = wordMultiplier(PREMIUM[r][c]);
+            int v = this->value(m.word[i]);
+            sum += v * lm;
+            mult *= wm;
+
+            // the word across the move through the new tile
+            int before = 0, after = 0, crossSum = 0;
+            for ( int k = 1; r - dc * k >= 0 && c - dr * k >= 0 && b[r - dc * k][c - dr * k]; ++k ) {
+                crossSum += this->value(b[r - dc * k][c - dr * k]);
+                ++before;
+            }
+            for ( int k = 1; r + dc * k < LEN && c + dr * k < LEN && b[r + dc * k][c + dr * k]; ++k ) {
+                crossSum += this->value(b[r + dc * k][c + dr * k]);
+                ++after;
+            }
+            if ( before + after > 0 ) {
+                crossTotal += (crossSum + v * lm) * wm;
+            }
+        }
+        return sum * mult + crossTotal + ( __builtin_popcount(m.placed) == RACKSIZE ? BINGO : 0 );
+    }
+};
+
+/**
+ * the tiles not yet drawn
+ * a draw takes a random tile and moves the last one into its place, putting a tile back
+ * appends it, so both are O(1). the random numbers come from the caller's generator,
+ * seed one per thread and keep it
+ */
+class Bag {
+
+private:
+    char tiles[TILES];
+    int count;
+
+public:
+
+    Bag() : count(0) {}
+
+    /**
+     * the full set of tiles
+     * @param alpha quantity of each letter and of the blank
+     */
+    void fill(const std::map<char, alphaData> &alpha) {
+
+        this->count = 0;
+        for ( auto it = alpha.begin(); it != alpha.end(); ++it ) {
+            for ( int q = 0; q < it->second.quantity && this->count < TILES; ++q ) {
+                this->tiles[this->count++] = it->first;
+            }
+        }
+    }
+
+    /**
+     * take a tile that is known to be out of the bag, on the board or on a rack
+     * @param t A-Z, BLANK, or a lower case letter for a blank on the board
+     * @return bool false when no such tile is left
+     */
+    bool remove(char t) {
+
+        if ( t >= 'a' && t <= 'z' ) {
+            t = BLANK;
+        }
+        for ( int i = 0; i < this->count; ++i ) {
+            if ( this->tiles[i] == t ) {
+                this->tiles[i] = this->tiles[--this->count];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @param rng
+     * @return char a random tile, taken out of the bag, which must not be empty
+     */
+    char draw(std::mt19937 &rng) {
+
+        int i = static_cast<int>((static_cast<uint64_t>(rng()) * static_cast<uint64_t>(this->count)) >> 32);
+        char t = this->tiles[i];
+        this->tiles[i] = this->tiles[--this->count];
+        return t;
+    }
+
+    /**
+     * draw up to n tiles
+     * @param rng
+     * @param out where the tiles go
+     * @param n
+     * @return int number drawn, less than n when the bag runs out
+     */
+    int draw(std::mt19937 &rng, char *out, int n) {
+
+        int drawn = 0;
+        for ( ; drawn < n && this->count > 0; ++drawn ) {
+            out[drawn] = this->draw(rng);
+        }
+        return drawn;
+    }
+
+    /**
+     * @param t a tile to go back in
+     */
+    void put(char t) {
+        this->tiles[this->count++] = t;
+    }
+
+    /**
+     * @return int tiles left
+     */
+    int size() const {
+        return this->count;
+    }
+};
+
+/**
+ * what precedes the values in a leave table file
+ */
+typedef struct lHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entries;
+    uint64_t games;
+    uint64_t samples;
+} leaveHeader;
+
+const char LEAVEMAGIC[8] = {'S', 'O', 'W', 'L', 'E', 'A', 'V', '\0'};
+const uint32_t LEAVEVERSION = 1;
+
+/**
+ * the worth of every leave, the tiles kept on the rack after a move, in points
+ *
+ * a leave is a multiset of up to RACKSIZE - 1 tiles out of 27 kinds, the blank last. its tiles in
+ * sorted order t0 <= t1 <= ... are made strictly increasing as ti + i and ranked in the combinatorial
+ * number system, so the index of a leave is a handful of additions out of a table of binomials and
+ * the values sit in one flat array with no hashing and no collisions. every multiset of each size gets
+ * a slot, the ones the tile distribution rules out included, 1107568 floats in all
+ */
+class LeaveTable {
+
+public:
+    static const int KINDS = 27;
+    static const int MAXLEAVE = RACKSIZE - 1;
+
+private:
+    uint32_t choose[KINDS + MAXLEAVE][MAXLEAVE + 1];
+    size_t offset[MAXLEAVE + 2];
+    std::vector<float> values;
+
+public:
+
+    LeaveTable() {
+
+        for ( int n = 0; n < KINDS + MAXLEAVE; ++n ) {
+            for ( int k = 0; k <= MAXLEAVE; ++k ) {
+                this->choose[n][k] = k == 0 ? 1 : ( n == 0 ? 0 : this->choose[n - 1][k - 1] + this->choose[n - 1][k] );
+            }
+        }
+
+        // the leaves of size s come after all the smaller ones, there are C(KINDS + s - 1, s) of them
+        this->offset[0] = 0;
+        for ( int s = 0; s <= MAXLEAVE; ++s ) {
+            this->offset[s + 1] = this->offset[s] + this->choose[KINDS + s - 1][s];
+        }
+    }
+
+    /**
+     * @return size_t slots in a table
+     */
+    size_t entries() const {
+        return this->offset[MAXLEAVE + 1];
+    }
+
+    /**
+     * @param counts tiles of each kind, 'A' to 'Z' and then the blank
+     * @return size_t the slot of the leave, entries() when it is too long
+     */
+    size_t index(const int *counts) const {
+
+        size_t rank = 0;
+        int i = 0;
+        for ( int t = 0; t < KINDS; ++t ) {
+            for ( int k = 0; k < counts[t]; ++k, ++i ) {
+                if ( i == MAXLEAVE ) {
+                    return this->entries();
+                }
+                rank += this->choose[t + i][i + 1];
+            }
+        }
+        return this->offset[i] + rank;
+    }
+
+    /**
+     * Helper Function
+     * @param tiles letters and blanks
+     * @param counts out, tiles of each kind
+     */
+    static void count(const std::string &tiles, int *counts) {
+
+        std::fill(counts, counts + KINDS, 0);
+        for ( char t : tiles ) {
+            ++counts[t == BLANK || ( t >= 'a' && t <= 'z' ) ? KINDS - 1 : t - 'A'];
+        }
+    }
+
+    /**
+     * @param counts tiles of each kind
+     * @return float what keeping them is worth, 0 without a table
+     */
+    float value(const int *counts) const {
+
+        size_t i = this->index(counts);
+        return i < this->values.size() ? this->values[i] : 0;
+    }
+
+    /**
+     * @param rack tiles of each kind on the rack
+     * @param m a move from it
+     * @return float what the tiles the move does not play are worth
+     */
+    float value(const int *rack, const move &m) const {
+
+        int left[KINDS];
+        std::copy(rack, rack + KINDS, left);
+        for ( int i = 0; i < m.length; ++i ) {
+            if ( m.placed & (1u << i) ) {
+                --left[m.word[i] >= 'a' ? KINDS - 1 : m.word[i] - 'A'];
+            }
+        }
+        return this->value(left);
+    }
+
+    /**
+     * @param i slot
+     * @param v its value, the table is sized on the first one
+     */
+    void set(size_t i, float v) {
+
+        if ( this->values.empty() ) {
+            this->values.assign(this->entries(), 0);
+        }
+        this->values[i] = v;
+    }
+
+    /**
+     * @return bool whether there are values
+     */
+    bool loaded() const {
+        return !this->values.empty();
+    }
+
+    /**
+     * write the table, to a temporary name first and renamed into place
+     * @param file
+     * @param games self play games it was built from
+     * @param samples leaves it was built from
+     * @return bool
+     */
+    bool save(const std::string &file, uint64_t games, uint64_t samples) const {
+
+        leaveHeader h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, LEAVEMAGIC, sizeof(h.magic));
+        h.version = LEAVEVERSION;
+        h.entries = static_cast<uint32_t>(this->values.size());
+        h.games = games;
+        h.samples = samples;
+
+        std::string tmp = file + ".tmp";
+        std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+        ofs.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        ofs.write(reinterpret_cast<const char*>(this->values.data()), this->values.size() * sizeof(float));
+        ofs.close();
+        if ( !ofs || std::rename(tmp.c_str(), file.c_str()) != 0 ) {
+            std::cout << "error writing file " << file << std::endl;
+            std::remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @param file
+     * @return bool false when there is no usable table, the reason is printed
+     */
+    bool load(const std::string &file) {
+
+        std::ifstream ifs(file, std::ios::binary);
+        if ( !ifs.is_open() ) {
+            std::cout << "error opening file " << file << std::endl;
+            return false;
+        }
+
+        leaveHeader h;
+        const char *why = nullptr;
+        std::vector<float> v;
+        if ( !ifs.read(reinterpret_cast<char*>(&h), sizeof(h)) ) {
+            why = "too short";
+        } else if ( std::memcmp(h.magic, LEAVEMAGIC, sizeof(h.magic)) != 0 ) {
+            why = "not a leave table";
+        } else if ( h.version != LEAVEVERSION || h.entries != this->entries() ) {
+            why = "version mismatch";
+        } else {
+            v.resize(h.entries);
+            if ( !ifs.read(reinterpret_cast<char*>(v.data()), v.size() * sizeof(float)) || ifs.peek() != EOF ) {
+                why = "truncated";
+            }
+        }
+        if ( why != nullptr ) {
+            std::cout << "ignoring " << file << ": " << why << std::endl;
+            return false;
+        }
+
+        this->values.swap(v);
+        return true;
+    }
+};
+
+/**
+ * the K best moves of a query, and every move that ties the K-th
+ * a heap of at most K moves with the weakest on top, and beside it the moves that tie the weakest.
+ * a move that does not make the cut costs one compare, the storage is kept from one query to the
+ * next so once it has grown nothing is allocated. of equal scores the move found first ranks first.
+ * moves rank by their points and the worth of their leave, which is 0 unless the caller set it
+ */
+class TopMoves {
+
+private:
+    typedef struct rData {
+        uint32_t seq;
+        move m;
+    } ranked;
+
+    std::vector<ranked> heap;
+    std::vector<ranked> ties;
+    size_t k;
+    uint32_t seq;
+
+    /**
+     * Helper Function
+     * heap order, the weakest move is the greatest
+     * @param x
+     * @param y
+     * @return bool x ranks above y
+     */
+    static bool better(const ranked &x, const ranked &y) {
+        return equity(x.m) > equity(y.m) || ( equity(x.m) == equity(y.m) && x.seq < y.seq );
+    }
+
+public:
+
+    /**
+     * @param m
+     * @return float what a move ranks by
+     */
+    static float equity(const move &m) {
+        return m.score + m.leave;
+    }
+
+    TopMoves() : k(1), seq(0) {}
+
+    /**
+     * start a query
+     * @param k how many moves, 1 at least
+     */
+    void reset(size_t k) {
+
+        this->k = std::max<size_t>(1, k);
+        this->seq = 0;
+        this->heap.clear();
+        this->ties.clear();
+        this->heap.reserve(this->k);
+    }
+
+    /**
+     * @param m a move found
+     */
+    void add(const move &m) {
+
+        if ( this->heap.size() < this->k ) {
+            this->heap.push_back(ranked{this->seq++, m});
+            std::push_heap(this->heap.begin(), this->heap.end(), better);
+            return;
+        }
+
+        float low = equity(this->heap.front().m);
+        float e = equity(m);
+        if ( e < low ) {
+            ++this->seq;
+            return;
+        }
+        if ( e == low ) {
+            this->ties.push_back(ranked{this->seq++, m});
+            return;
+        }
+
+        // the weakest goes, and its ties with it unless the next weakest still ties them
+        std::pop_heap(this->heap.begin(), this->heap.end(), better);
+        ranked out = this->heap.back();
+        this->heap.back() = ranked{this->seq++, m};
+        std::push_heap(this->heap.begin(), this->heap.end(), better);
+        if ( equity(this->heap.front().m) == low ) {
+            this->ties.push_back(out);
+        } else {
+            this->ties.clear();
+        }
+    }
+
+    /**
+     * end the query, the moves best first
+     */
+    void finish() {
+
+        this->heap.insert(this->heap.end(), this->ties.begin(), this->ties.end());
+        this->ties.clear();
+        std::sort(this->heap.begin(), this->heap.end(), better);
+    }
+
+    /**
+     * @return size_t moves kept, K or more with the ties
+     */
+    size_t size() const {
+        return this->heap.size();
+    }
+
+    bool empty() const {
+        return this->heap.empty();
+    }
+
+    /**
+     * @param i rank, after finish
+     * @return const move&
+     */
+    const move &operator[](size_t i) const {
+        return this->heap[i].m;
+    }
+};
+
+/**
+ * one rack query: the rack and how many of the best moves it wants, the moves it gets back
+ * and the scratch they are worked out in
+ * every query has its own, so one board can answer many of them at once
+ */
+typedef struct eData {
+    std::string rack;
+    int top = 1;
+    TopMoves bestWords;
+    size_t moveCount;
+    double elapsed_secs;
+} evaluation;
 
 class Board {
 
 private:
     // hold all the legal words in here
-    std::set<std::string> sowpods;
+    Dictionary sowpods;
     bool sowpodsLoaded;
+    bool useImage;
+    double load_secs;
+
+    // the words a rack can make, by their sorted letters
+    AnagramIndex anagrams;
+
+    // what the tiles left on the rack are worth, empty unless --leaves
+    LeaveTable leaves;
 
     // the actual board
     char b[LEN][LEN];
@@ -47,8 +1564,9 @@ private:
     // the rack
     std::string rack;
 
-    // best word choice
-    std::map<int,std::string> bestWords;
+    // the tiles to draw from, and one generator for every draw
+    Bag bag;
+    std::mt19937 mt;
 
     // test cases
     std::set<std::string> tests;
@@ -57,32 +1575,19 @@ private:
 
     bool loadSowpods() {
 
-        // load from the file
-        std::ifstream ifs;
-        std::string value;
-        ifs.open("SOWPODS_complete.txt");
-        if (ifs.is_open()) {
+        std::clock_t begin = clock();
 
-            while (!ifs.eof()) {
-                std::getline(ifs, value);
-                if ( value.size() != 0 ) {
-                    if (!value.empty() && value[value.size() - 1] == '\r')
-                        value.erase(value.size() - 1);
-                    this->sowpods.insert(value);
-                }
-                value.clear();
-            }
-        } else {
-            std::cout << "error opening file SOWPODS_complete.txt" << std::endl;
-            return false;
-        }
-        ifs.close();
-        if (ifs.is_open()) {
-            std::cout << "error closing file SOWPODS_complete.txt" << std::endl;
-            return false;
+        // the compiled image is preferred, the text list is the fallback
+        bool loaded = ( this->useImage && this->sowpods.map(IMAGEFILE, Dictionary::fileSize(WORDFILE)) ) ||
+                      this->sowpods.load(WORDFILE);
+
+        // the anagram index the same way, built from the word graph when there is no good image of it
+        if ( loaded && !( this->useImage && this->anagrams.map(ANAGRAMFILE, Dictionary::fileSize(WORDFILE), RACKSIZE) ) ) {
+            this->anagrams.build(this->sowpods, RACKSIZE);
         }
 
-        return true;
+        this->load_secs = double(clock() - begin) / CLOCKS_PER_SEC;
+        return loaded;
     }
 
     void loadTestCases() {
@@ -112,189 +1617,279 @@ private:
         }
     }
 
-    double elapsed_secs;
-    std::string startingSquare;
-
     /**
      * generate 7 letter string from the 100 letters
+     * the tiles come out of the bag, refilled when it runs short
      * @return string
      */
     std::string generateRack() {
 
-        std::random_device rd;
-        std::mt19937 mt(rd());
-        // 0-26 is A-Z and BLANK
-        std::uniform_int_distribution<int> dist(0, 26);
+        if ( this->bag.size() < RACKSIZE ) {
+            this->bag.fill(this->alpha);
+        }
+
+        char tiles[RACKSIZE];
+        int n = this->bag.draw(this->mt, tiles, RACKSIZE);
+        return std::string(tiles, n);
+    }
+
+    /**
+     * get the move with the heighest points
+     * for the Rack anywhere on the board
+     *
+     * the generator scores every legal move exactly, premium squares, cross words and bingo included.
+     * with a leave table the moves rank by their points and the worth of what they leave on the rack.
+     * nothing here touches the board object, the same board can be asked from many threads
+     * as long as each brings its own generator and evaluation
+     *
+     * @param gen
+     * @param board
+     * @param e the rack in, the moves out
+     */
+    void chooseWordFromRack(MoveGenerator &gen, const char (&board)[LEN][LEN], evaluation &e) const {
+
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
 
-        std::string rack;
-        std::map<char, int> picks;
-        std::map<char, int>::iterator it;
-        int rn = 0;
-        char rl = '\0'; // random letter in the range of the uniform distribution
+        int counts[LeaveTable::KINDS];
+        LeaveTable::count(e.rack, counts);
+        const LeaveTable &leaves = this->leaves;
 
-        // get all the seven letters or blanks
-        for (unsigned int i = 0; i < RACKSIZE; ++i) {
+        e.bestWords.reset(e.top);
+        e.moveCount = 0;
+        gen.generate(board, e.rack, [&](const move &m) {
 
-            // pick a letter
-            rn = dist(mt);
-            if (rn == 26) {
-                rl = BLANK;
+            if ( leaves.loaded() ) {
+                move kept = m;
+                kept.leave = leaves.value(counts, m);
+                e.bestWords.add(kept);
             } else {
-                rl = static_cast<char>(rn + 65);
+                e.bestWords.add(m);
             }
+            ++e.moveCount;
+        });
+        e.bestWords.finish();
 
-            // check if we had already picked this letter
-            it = picks.find(rl);
+        e.elapsed_secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    }
+
+    /**
+     * Helper Function
+     * a query: a rack of one to RACKSIZE letters or blanks, lower case taken as upper case,
+     * and after it how many of the best moves to return, when that is not the default
+     * @param line
+     * @param rack
+     * @param top
+     * @return bool
+     */
+    static bool parseRack(const std::string &line, std::string &rack, int &top) {
+
+        size_t i = 0;
+        rack.clear();
+        for ( ; i < line.size() && line[i] != ' ' && line[i] != '\t'; ++i ) {
+            char c = static_cast<char>(std::toupper(static_cast<unsigned char>(line[i])));
+            if ( c != BLANK && ( c < 'A' || c > 'Z' ) ) {
+                return false;
+            }
+            rack += c;
+        }
+        if ( rack.empty() || rack.size() > RACKSIZE ) {
+            return false;
+        }
+
+        for ( ; i < line.size() && ( line[i] == ' ' || line[i] == '\t' ); ++i ) {}
+        if ( i < line.size() ) {
+            char *end = nullptr;
+            long k = std::strtol(line.c_str() + i, &end, 10);
+            if ( k < 1 || k > 1000 || *end != '\0' ) {
+                return false;
+            }
+            top = static_cast<int>(k);
+        }
+        return true;
+    }
+
+    /**
+     * Helper Function
+     * @param m
+     * @return std::string the move and its points, with the breakdown, the leave and the equity when there is a table
+     */
+    std::string describe(const move &m) const {
+
+        std::string d = std::string(m.word) + " " + std::to_string(m.row) + "," + std::to_string(m.col) + " " +
+                        (m.across ? "ACROSS" : "DOWN") + " " + std::to_string(m.score) + " (" +
+                        std::to_string(m.mainScore) + " + " + std::to_string(m.crossScore) + " + " +
+                        std::to_string(m.bingo) + ")";
+        if ( this->leaves.loaded() ) {
+            char leave[48];
+            std::snprintf(leave, sizeof(leave), " LEAVE %+.1f EQUITY %.1f", m.leave, TopMoves::equity(m));
+            d += leave;
+        }
+        return d;
+    }
+
+    /**
+     * Helper Function
+     * whether the tiles just laid make a legal move: in one line with no gap, every word they make
+     * is in the dictionary, and they hook onto the tiles there or cover the centre of an empty board
+     * @param before the board without the tiles
+     * @param after the board with them
+     * @param squares where they went, in order along the line
+     * @param count how many
+     * @return bool
+     */
+    bool legal(const char (&before)[LEN][LEN], const char (&after)[LEN][LEN], const int (*squares)[2], int count) const {
+
+        bool empty = true;
+        for ( int r = 0; r < LEN && empty; ++r ) {
+            for ( int c = 0; c < LEN && empty; ++c ) {
+                empty = before[r][c] == '\0';
+            }
+        }
 
-            // letter has been picked but exceeded what was allowed in quantity for the letter
-            // therefore pick another from the random number generator
-            while (it != picks.end() && (it->second + 1) > this->alpha.find(rl)->second.quantity) {
+        bool hooked = false;
+        for ( int i = 0; i < count; ++i ) {
+            int r = squares[i][0], c = squares[i][1];
+            if ( empty ) {
+                hooked = hooked || ( r == LEN / 2 && c == LEN / 2 );
+            } else {
+                hooked = hooked || ( r > 0 && before[r - 1][c] ) || ( r < LEN - 1 && before[r + 1][c] ) ||
+                         ( c > 0 && before[r][c - 1] ) || ( c < LEN - 1 && before[r][c + 1] );
+            }
+        }
+        if ( !hooked || ( empty && count < 2 ) ) {
+            return false;
+        }
 
-                //std::cout << "got to pick again, old value .." << it->first << " position " << i << " q : " << it->second << std::endl;
-                // pick a letter
-                rn = dist(mt);
-                if (rn == 26) {
-                    rl = BLANK;
-                } else {
-                    rl = static_cast<char>(rn + 65);
+        // every run of two or more letters through a new tile, both ways
+        int longest = 0;
+        for ( int i = 0; i < count; ++i ) {
+            for ( int d = 0; d < 2; ++d ) {
+                int dr = d, dc = 1 - d;
+                int r = squares[i][0], c = squares[i][1];
+                while ( r - dr >= 0 && c - dc >= 0 && after[r - dr][c - dc] ) {
+                    r -= dr;
+                    c -= dc;
+                }
+                std::string w;
+                for ( ; r < LEN && c < LEN && after[r][c]; r += dr, c += dc ) {
+                    w += static_cast<char>(std::toupper(after[r][c]));
+                }
+                longest = std::max(longest, static_cast<int>(w.size()));
+                if ( w.size() >= 2 && !this->sowpods.contains(w) ) {
+                    return false;
                 }
-                it = picks.find(rl);
-
             }
+        }
+        return longest >= 2;
+    }
 
-            if (it == picks.end()) {
-
-                // note that this letter has been picked 1 time.
-                picks.emplace(std::make_pair(rl, 1));
-
-            } else {
-
-                // keep track of the times the letter was picked up
-                it->second++;
+    /**
+     * Helper Function
+     * @param m a move
+     * @return std::string the squares and letters of its new tiles, the same for the same tiles whichever way they are found
+     */
+    static std::string placement(const move &m) {
+
+        std::string k;
+        for ( int i = 0; i < m.length; ++i ) {
+            if ( m.placed & (1u << i) ) {
+                k += static_cast<char>('a' + (m.across ? m.row : m.row + i));
+                k += static_cast<char>('a' + (m.across ? m.col + i : m.col));
+                k += m.word[i];
             }
-
-            // the actual letter that is picked to the rack
-            rack.insert(i, 1, rl);
-
         }
-
-        return rack;
-
+        return k;
     }
 
     /**
-     * get word with the heighest point
-     * from the Rack that meet with sowpods
-     *
-     * produce permutations choose k from N until k = N
-     * Sigma[k=2 to N ] N!/ ( N-k)!
-     *
-     * @param rack
+     * Helper Function
+     * brute force: lay the rack tiles one after another along a line from a starting square,
+     * in every order and with every letter for a blank, and keep whatever is legal
+     * @param board
+     * @param after board with the tiles laid so far
+     * @param rack tiles left, BLANK marks one that is used up
+     * @param r next square
+     * @param c
+     * @param dr direction
+     * @param dc
+     * @param squares tiles laid so far
+     * @param count
+     * @param found placements of the legal moves, sorted by square
      */
-    void chooseWordFromRack(std::string rack) {
+    void layAll(const char (&board)[LEN][LEN], char (&after)[LEN][LEN], std::string &rack, int r, int c, int dr, int dc,
+                int (*squares)[2], int count, std::set<std::string> &found) const {
 
-        std::clock_t begin = clock();
-
-        // make sure its first sorted
-        // http://en.cppreference.com/w/cpp/algorithm/sort
-        // O(nlogn)
-        std::sort(rack.begin(),rack.end());
-
-        std::string s;
-        unsigned long pos = 0;
+        while ( r < LEN && c < LEN && after[r][c] ) {
+            r += dr;
+            c += dc;
+        }
+        if ( r >= LEN || c >= LEN ) {
+            return;
+        }
 
-        for ( unsigned int k = 2 ; k <= rack.size(); ++k ) {
+        std::string tried;
+        for ( size_t i = 0; i < rack.size(); ++i ) {
 
-            do {
-                for ( unsigned int i = 0 ; i < k; ++i ) {
-                    s.insert(i,1,rack[i]) ;
+            char t = rack[i];
+            if ( t == '\0' || tried.find(t) != std::string::npos ) {
+                continue;
+            }
+            tried += t;
+            rack[i] = '\0';
+            squares[count][0] = r;
+            squares[count][1] = c;
+            for ( char l = 'A'; l <= 'Z'; ++l ) {
+
+                if ( t != BLANK && l != t ) {
+                    continue;
                 }
-                //std::cout << " string " << s << std::endl;
-
-                // s is now a candidate
-                pos = s.find(BLANK);
-                if ( pos < s.size() ) {
-                    while ( pos < s.size() ) {
-                        // s contains blanks
-                        // find returns the position
-
-                        // try all the alphabets for BLANK
-                        for ( auto it = this->alpha.begin(); it != this->alpha.end(); ++it) {
-
-                            // it is a sorted map.. should be the last key
-                            if ( it->first == BLANK ) {
-                                break;
-                            }
-
-                            // make sure we dont pick more letters than allowed
-                            if ( std::count(s.begin(), s.end(),it->first) + 1 <= it->second.quantity ) {
-                                s.replace(pos, 1, 1, it->first);
-                            } else {
-                                continue;
-                            }
-
-                            // check if s is in sowpods
-                            auto search = this->sowpods.find(s);
-                            if ( search != this->sowpods.end() ) {
-
-                                // calculate points except for the blanks, thats pos
-                                int points = 0;
-                                for ( unsigned long p = 0 ; p < s.size(); ++p ) {
-                                    if ( p != pos ) {
-                                        points += this->alpha.find(s[p])->second.points;
-                                    }
-                                }
-                                // add to ordered map where the key is the points, and later pick the last key
-                                // that would be the best word
-                                this->bestWords.emplace(std::make_pair(points,s));
-                            }
-
-                        }
-
-
-                        pos = s.find(BLANK);
+                after[r][c] = t == BLANK ? static_cast<char>(std::tolower(l)) : l;
+                if ( this->legal(board, after, squares, count + 1) ) {
+                    std::string k;
+                    std::vector<std::pair<int, int>> order;
+                    for ( int j = 0; j <= count; ++j ) {
+                        order.push_back(std::make_pair(squares[j][0], squares[j][1]));
                     }
-                } else {
-
-                    // check if s is in sowpods
-                    auto search = this->sowpods.find(s);
-                    if ( search != this->sowpods.end() ) {
-
-                        // calculate points
-                        int points = 0;
-                        for (unsigned long p = 0; p < s.size(); ++p) {
-                            points += this->alpha.find(s[p])->second.points;
-                        }
-                        // add to ordered map where the key is the points, and later pick the last key
-                        // that would be the best word
-                        this->bestWords.emplace(std::make_pair(points, s));
+                    std::sort(order.begin(), order.end());
+                    for ( const std::pair<int, int> &q : order ) {
+                        k += static_cast<char>('a' + q.first);
+                        k += static_cast<char>('a' + q.second);
+                        k += after[q.first][q.second];
                     }
+                    found.insert(k);
                 }
-                // done with this permutation
-                s.clear();
-
-
-                // meet half way N/2
-                std::reverse( rack.begin() + k ,rack.end() );
+                this->layAll(board, after, rack, r + dr, c + dc, dr, dc, squares, count + 1, found);
+            }
+            after[r][c] = '\0';
+            rack[i] = t;
+        }
+    }
 
-                // O(N/2) per output
-            } while(std::next_permutation(rack.begin(), rack.end()));
+    /**
+     * print the best move for the rack, then the ones that tie it and the rest of the K best
+     * @param e
+     */
+    void report(const evaluation &e) const {
 
+        std::cout << "RACK:" << e.rack << std::endl;
+        if ( e.bestWords.empty() ) {
+            std::cout << "NO MOVE" << std::endl;
+        } else {
+            std::cout << "PLACE WORD " << describe(e.bestWords[0]) << std::endl;
         }
-
-        clock_t end = clock();
-        this->elapsed_secs = double(end - begin) / CLOCKS_PER_SEC;
+        // the moves are ranked by equity, so a move ties the one ranked just above it on equity, not points
+        for ( size_t i = 1; i < e.bestWords.size(); ++i ) {
+            bool tied = TopMoves::equity(e.bestWords[i]) == TopMoves::equity(e.bestWords[i - 1]);
+            std::cout << ( tied ? "TIED WORD " : "NEXT WORD " )
+                      << describe(e.bestWords[i]) << std::endl;
+        }
+        std::cout << "MOVES:" << e.moveCount << std::endl;
+        std::cout << "ELAPSED TIME:" << e.elapsed_secs << " seconds" << std::endl;
     }
 
 
 public :
 
-    //double word
-    // for this requirement we are only figuring out the very first word
-    // so just the fact b[7][7] needs to be identified that word is doubled.
-    const int dwRow = 7;
-    const int dwCol = 7;
-
     // individual alphabet points
     const std::map<char, alphaData> alpha = {
             {'A',   {1,  9}},
@@ -327,9 +1922,13 @@ public :
     };
 
 
-    Board() {
+    /**
+     * @param useImage map the compiled dictionary image when there is a good one
+     */
+    explicit Board(bool useImage = true) : useImage(useImage), load_secs(0), mt(std::random_device()()),
+                                           generator(sowpods, anagrams, alpha) {
 
-        // load the sowpods into an ordered redblack tree std::set
+        // load the sowpods into the word graph, and its anagram index
         this->sowpodsLoaded = this->loadSowpods();
 
         // initialize the board
@@ -340,109 +1939,933 @@ public :
         }
 
         this->loadTestCases();
+        this->bag.fill(this->alpha);
+
+    }
+
+    /**
+     * rank moves by points and leave from here on
+     * @param file
+     * @return bool
+     */
+    bool loadLeaves(const std::string &file) {
 
+        return this->leaves.load(file);
     }
 
     ~Board() {
 
-        this->sowpods.clear();
         this->tests.clear();
-        this->bestWords.clear();
     }
 
     /**
      * get stats
      */
 
-    void stats() {
+    /**
+     * @param draw when above 0, that many racks drawn from the bag instead of the test racks
+     * @param seed seeds the draws
+     * @param top how many of the best moves to show for each rack
+     */
+    void stats(int draw = 0, unsigned int seed = 0, int top = 1) {
 
         // this is from the bag
-        //this->rack = this->generateRack();
+        std::set<std::string> drawn;
+        if ( draw > 0 ) {
+            this->mt.seed(seed);
+            this->bag.fill(this->alpha);
+            for ( int i = 0; i < draw; ++i ) {
+                drawn.insert(this->generateRack());
+            }
+        }
+        const std::set<std::string> &racks = draw > 0 ? drawn : this->tests;
+
+        std::cout << "DICTIONARY:" << this->sowpods.words() << " words " << this->sowpods.size() << " states "
+                  << this->sowpods.bytes() << " bytes " << (this->sowpods.mapped() ? IMAGEFILE : WORDFILE) << std::endl;
+        std::cout << "ANAGRAMS:" << this->anagrams.size() << " words " << this->anagrams.groups() << " signatures "
+                  << (this->anagrams.mapped() ? ANAGRAMFILE : "built") << std::endl;
+        std::cout << "LOAD TIME:" << this->load_secs << " seconds" << std::endl;
+        if ( this->leaves.loaded() ) {
+            std::cout << "LEAVES:" << this->leaves.entries() << " entries" << std::endl;
+        }
+
+        // this is from the test cases, each one as the opening move
+        evaluation e;
+        e.top = top;
+        for ( auto it = racks.begin(); it != racks.end(); ++it) {
+
+            e.rack = *(it);
+            this->chooseWordFromRack(this->generator, this->b, e);
+            this->report(e);
+        }
+
+
+
+
+
+    }
+
+
+    /**
+     * print the board, a dot for an empty square and lower case for a blank
+     */
+    void printBoard() const {
+
+        for (int i = 0; i < LEN; ++i) {
+            std::string line;
+            for (int j = 0; j < LEN; ++j) {
+                line += this->b[i][j] ? this->b[i][j] : '.';
+            }
+            std::cout << line << std::endl;
+        }
+    }
+
+    /**
+     * put the tiles of a move on the board
+     * @param m
+     */
+    void place(const move &m) {
+
+        for ( int i = 0; i < m.length; ++i ) {
+            if ( m.placed & (1u << i) ) {
+                int r = m.across ? m.row : m.row + i;
+                int c = m.across ? m.col + i : m.col;
+                this->b[r][c] = m.word[i];
+            }
+        }
+    }
 
-        // this is from the test cases
+    /**
+     * play the test racks one after the other on the same board,
+     * each time the move with the most points anywhere on the board
+     * @param top how many of the best moves to show for each rack
+     */
+    void play(int top = 1) {
+
+        evaluation e;
+        e.top = top;
         for ( auto it = this->tests.begin(); it != this->tests.end(); ++it) {
 
+            e.rack = *(it);
+            this->chooseWordFromRack(this->generator, this->b, e);
+            this->report(e);
+            if ( !e.bestWords.empty() ) {
+                this->place(e.bestWords[0]);
+            }
+        }
+
+        this->printBoard();
+    }
+
+    /**
+     * answer rack queries, one rack a line, on a pool of threads
+     * the board, the dictionary and the anagram index are only read, each thread has its own generator
+     * and every query its own evaluation, so nothing is shared that is written.
+     * the racks are read into a window of slots as they come in, the threads take the next one off a
+     * shared counter and whichever thread finishes the oldest one prints the run of finished answers,
+     * one line each, in input order. a query is answered as soon as it is in, the input does not
+     * have to end or fill a chunk first, which is what a client on the other end of a pipe needs
+     * a query line is a rack and, optionally, how many of the best moves it wants.
+     * the answer line is the rack and then the moves, best first, with every move that ties the last
+     * @param name file or "-" for stdin
+     * @param threads pool size
+     * @param top how many of the best moves when the query does not say
+     * @return int exit code
+     */
+    int batch(const std::string &name, int threads, int top) const {
+
+        const long long WINDOW = 1024;
+
+        std::ifstream ifs;
+        std::istream *in = &std::cin;
+        if ( name != "-" ) {
+            ifs.open(name);
+            if ( !ifs.is_open() ) {
+                std::cout << "error opening file " << name << std::endl;
+                return 1;
+            }
+            in = &ifs;
+        }
+
+        typedef struct jData { std::string line; bool valid; evaluation e; } job;
+        std::vector<job> jobs(WINDOW);
+        std::vector<char> done(WINDOW, 0);
+        std::mutex mtx;
+        std::condition_variable cv;
+        long long read = 0, taken = 0, printed = 0, invalid = 0;
+        bool eof = false;
+
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> pool;
+        for ( int t = 0; t < threads; ++t ) {
+
+            pool.push_back(std::thread([&]() {
+
+                MoveGenerator gen(this->sowpods, this->anagrams, this->alpha);
+                std::string out;
+                std::unique_lock<std::mutex> lock(mtx);
+                for ( ;; ) {
+
+                    cv.wait(lock, [&]() { return taken < read || eof; });
+                    if ( taken == read ) {
+                        return;
+                    }
+                    long long i = taken++;
+                    job &j = jobs[i % WINDOW];
+                    lock.unlock();
+
+                    // the slot is not written again until it is printed
+                    j.e.top = top;
+                    j.valid = parseRack(j.line, j.e.rack, j.e.top);
+                    if ( j.valid ) {
+                        this->chooseWordFromRack(gen, this->b, j.e);
+                    }
+
+                    lock.lock();
+                    done[i % WINDOW] = 1;
+                    while ( printed < read && done[printed % WINDOW] ) {
+
+                        job &p = jobs[printed % WINDOW];
+                        out.clear();
+                        if ( !p.valid ) {
+                            out = p.line + " INVALID RACK";
+                            ++invalid;
+                        } else if ( p.e.bestWords.empty() ) {
+                            out = p.e.rack + " NO MOVE";
+                        } else {
+                            out = p.e.rack;
+                            for ( size_t m = 0; m < p.e.bestWords.size(); ++m ) {
+                                out += ( m == 0 ? " " : " | " ) + describe(p.e.bestWords[m]);
+                            }
+                        }
+                        std::cout << out << '\n';
+                        done[printed % WINDOW] = 0;
+                        ++printed;
+                    }
+
+                    // flushed when caught up, not a line at a time while there is more to come
+                    if ( printed == read ) {
+                        std::cout.flush();
+                    }
+                    cv.notify_all();
+                }
+            }));
+        }
+
+        std::string line;
+        while ( std::getline(*in, line) ) {
+
+            if ( !line.empty() && line[line.size() - 1] == '\r' ) {
+                line.erase(line.size() - 1);
+            }
+            if ( line.empty() ) {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [&]() { return read - printed < WINDOW; });
+            jobs[read % WINDOW].line.swap(line);
+            ++read;
+            cv.notify_all();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            eof = true;
+            cv.notify_all();
+        }
+        for ( std::thread &t : pool ) {
+            t.join();
+        }
+
+        // the answers own stdout, the summary goes beside them
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        std::cerr << "BATCH:" << read << " racks " << invalid << " invalid " << threads << " threads in " << secs
+                  << " seconds, " << (secs > 0 ? read / secs : 0) << " per second" << std::endl;
+        return 0;
+    }
+
+    /**
+     * rank the best moves for each test rack by equity: the points of the move less the points
+     * of the opponent's best reply, averaged over random racks drawn from the tiles the player can not see.
+     * the playouts are split into tasks of one candidate and a slice of the racks, each with its own
+     * seeded generator, so the numbers do not depend on the number of threads.
+     * a playout draws into a fixed buffer, keeps the best reply in a local and puts the tiles back,
+     * nothing in the loop allocates
+     * @param iterations opponent racks per candidate
+     * @param candidates how many of the best scoring moves to simulate
+     * @param threads
+     * @param seed
+     */
+    void simulate(int iterations, int candidates, int threads, unsigned int seed) {
+
+        const int SLICES = 16;
+        int rackNo = 0;
+        for ( auto it = this->tests.begin(); it != this->tests.end(); ++it, ++rackNo ) {
+
             this->rack = *(it);
-            this->chooseWordFromRack(this->rack);
+            std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+            // the candidates stop at K, a tie past the K-th is not simulated
+            TopMoves best;
+            best.reset(candidates);
+            this->generator.generate(this->b, this->rack, [&best](const move &m) { best.add(m); });
+            best.finish();
+            std::vector<move> moves;
+            for ( size_t i = 0; i < best.size() && static_cast<int>(i) < candidates; ++i ) {
+                moves.push_back(best[i]);
+            }
 
-            // figure out where to put it on the board
-            std::string w = this->bestWords.rbegin()->second;
-            int totalPoints = 0;
+            // the opponent draws from whatever is not on the board or on this rack
+            Bag unseen;
+            unseen.fill(this->alpha);
+            for ( int r = 0; r < LEN; ++r ) {
+                for ( int c = 0; c < LEN; ++c ) {
+                    if ( this->b[r][c] ) {
+                        unseen.remove(this->b[r][c]);
+                    }
+                }
+            }
+            for ( char t : this->rack ) {
+                unseen.remove(t);
+            }
 
-            if ( w.size() < 5 ) {
+            struct tally { double sum; double squares; int n; };
+            int tasks = static_cast<int>(moves.size()) * SLICES;
+            std::vector<tally> tallies(tasks, tally{0, 0, 0});
+            std::atomic<int> next(0);
 
-                for ( unsigned long i = 0 ; i < w.size(); ++i)
-                    this->b[this->dwRow][this->dwCol+i] = w[i];
+            std::vector<std::thread> pool;
+            for ( int t = 0; t < threads; ++t ) {
 
-                this->startingSquare = std::to_string(this->dwRow) + "," + std::to_string(this->dwCol);
+                pool.push_back(std::thread([&]() {
 
-            } else if ( w.size() == 5 ){
+                    MoveGenerator gen(this->sowpods, this->anagrams, this->alpha);
+                    char board[LEN][LEN];
+                    char tiles[RACKSIZE];
+                    for ( int k = next++; k < tasks; k = next++ ) {
 
-                if ( this->alpha.find(w[0])->second.points >= this->alpha.find(w[4])->second.points ) {
+                        const move &m = moves[k / SLICES];
+                        int slice = k % SLICES;
+                        std::seed_seq seq{seed, static_cast<unsigned int>(rackNo), static_cast<unsigned int>(k / SLICES),
+                                          static_cast<unsigned int>(slice)};
+                        std::mt19937 rng(seq);
 
-                    totalPoints = this->alpha.find(w[0])->second.points * 2;
-                    for ( unsigned long i = 0 ; i < w.size(); ++i)
-                        this->b[this->dwRow][3+i] = w[i];
+                        std::memcpy(board, this->b, sizeof(board));
+                        for ( int i = 0; i < m.length; ++i ) {
+                            if ( m.placed & (1u << i) ) {
+                                board[m.across ? m.row : m.row + i][m.across ? m.col + i : m.col] = m.word[i];
+                            }
+                        }
 
-                    this->startingSquare = std::to_string(this->dwRow) + "," + std::to_string(3);
+                        Bag local = unseen;
+                        tally &out = tallies[k];
+                        int runs = iterations / SLICES + ( slice < iterations % SLICES ? 1 : 0 );
+                        for ( int i = 0; i < runs; ++i ) {
 
-                } else {
+                            int n = local.draw(rng, tiles, RACKSIZE);
+                            int best = 0;
+                            gen.generate(board, tiles, n, [&best](const move &reply) {
+                                if ( reply.score > best ) {
+                                    best = reply.score;
+                                }
+                            });
+                            while ( n > 0 ) {
+                                local.put(tiles[--n]);
+                            }
 
-                    totalPoints = this->alpha.find(w[4])->second.points * 2;
-                    for ( unsigned long i = 0 ; i < w.size(); ++i)
-                        this->b[this->dwRow][this->dwCol+i] = w[i];
+                            out.sum += best;
+                            out.squares += static_cast<double>(best) * best;
+                            ++out.n;
+                        }
+                    }
+                }));
+            }
+            for ( std::thread &t : pool ) {
+                t.join();
+            }
 
-                    this->startingSquare = std::to_string(this->dwRow) + "," + std::to_string(this->dwCol);
+            // equity of each candidate, best first
+            std::vector<std::pair<double, int>> ranked;
+            std::vector<double> reply(moves.size()), error(moves.size());
+            for ( size_t c = 0; c < moves.size(); ++c ) {
+                tally all = {0, 0, 0};
+                for ( int slice = 0; slice < SLICES; ++slice ) {
+                    const tally &t = tallies[c * SLICES + slice];
+                    all.sum += t.sum;
+                    all.squares += t.squares;
+                    all.n += t.n;
                 }
+                double mean = all.n > 0 ? all.sum / all.n : 0;
+                double variance = all.n > 1 ? (all.squares - all.n * mean * mean) / (all.n - 1) : 0;
+                reply[c] = mean;
+                error[c] = all.n > 0 ? std::sqrt(std::max(0.0, variance) / all.n) : 0;
+                ranked.push_back(std::make_pair(moves[c].score - mean, static_cast<int>(c)));
+            }
+            std::stable_sort(ranked.begin(), ranked.end(), [](const std::pair<double, int> &x, const std::pair<double, int> &y) {
+                return x.first > y.first;
+            });
+
+            double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            std::cout << "RACK:" << this->rack << std::endl;
+            for ( const std::pair<double, int> &r : ranked ) {
+                const move &m = moves[r.second];
+                std::cout << "SIMULATE WORD " << m.word << " " << m.row << "," << m.col << " " << (m.across ? "ACROSS" : "DOWN")
+                          << " " << m.score << " REPLY " << reply[r.second] << " +- " << error[r.second]
+                          << " EQUITY " << r.first << std::endl;
+            }
+            std::cout << "PLAYOUTS:" << tasks / SLICES * iterations << " in " << secs << " seconds, "
+                      << (secs > 0 ? tasks / SLICES * iterations / secs : 0) << " per second" << std::endl;
+        }
+    }
 
-            } else {
+    /**
+     * build the leave table from self play
+     * two players take turns with the best move, by points, or by points and leave when a table is
+     * loaded so a table can be rebuilt from its own play. every leave kept while the bag can still
+     * fill the rack is a sample, worth what its player scores the next turn less the average next turn.
+     * a leave seen often enough takes its own average, the rest lean on the sum of what each of their
+     * tiles is worth, the residual of every sample shared out over the tiles kept
+     * the games are spread over the threads, each seeded from the seed and its number, so the table
+     * does not depend on the number of threads
+     * @param games
+     * @param threads
+     * @param seed
+     * @param file where the table goes
+     * @return int exit code
+     */
+    int buildLeaves(int games, int threads, unsigned int seed, const std::string &file) {
+
+        // samples a leave needs before its own average counts as much as the estimate from its tiles,
+        // the next turn varies by some 30 points so a handful of samples on their own are mostly noise
+        const double PRIOR = 50;
+        const int KINDS = LeaveTable::KINDS;
+
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+        std::vector<std::vector<std::pair<uint32_t, int>>> samples(games);
+        std::atomic<int> next(0);
+        std::vector<std::thread> pool;
+        for ( int t = 0; t < threads; ++t ) {
+
+            pool.push_back(std::thread([&]() {
+
+                MoveGenerator gen(this->sowpods, this->anagrams, this->alpha);
+                evaluation e;
+                for ( int g = next++; g < games; g = next++ ) {
+
+                    std::seed_seq seq{seed, static_cast<unsigned int>(g)};
+                    std::mt19937 rng(seq);
+
+                    char board[LEN][LEN];
+                    std::memset(board, 0, sizeof(board));
+                    Bag bag;
+                    bag.fill(this->alpha);
+                    char racks[2][RACKSIZE];
+                    int sizes[2];
+                    long long pending[2] = {-1, -1};
+                    for ( int p = 0; p < 2; ++p ) {
+                        sizes[p] = bag.draw(rng, racks[p], RACKSIZE);
+                    }
+
+                    for ( int turn = 0, passes = 0; turn < 100 && passes < 2; ++turn ) {
+
+                        int p = turn & 1;
+                        e.rack.assign(racks[p], sizes[p]);
+                        this->chooseWordFromRack(gen, board, e);
+
+                        if ( pending[p] >= 0 ) {
+                            samples[g].push_back(std::make_pair(static_cast<uint32_t>(pending[p]),
+                                                                e.bestWords.empty() ? 0 : e.bestWords[0].score));
+                            pending[p] = -1;
+                        }
+                        if ( e.bestWords.empty() ) {
+                            ++passes;
+                            continue;
+                        }
+                        passes = 0;
+
+                        const move &m = e.bestWords[0];
+                        for ( int i = 0; i < m.length; ++i ) {
+                            if ( m.placed & (1u << i) ) {
+                                board[m.across ? m.row : m.row + i][m.across ? m.col + i : m.col] = m.word[i];
+                                char t = m.word[i] >= 'a' ? BLANK : m.word[i];
+                                char *at = std::find(racks[p], racks[p] + sizes[p], t);
+                                *at = racks[p][--sizes[p]];
+                            }
+                        }
+
+                        if ( bag.size() >= __builtin_popcount(m.placed) ) {
+                            int counts[KINDS];
+                            LeaveTable::count(std::string(racks[p], sizes[p]), counts);
+                            pending[p] = static_cast<long long>(this->leaves.index(counts));
+                        }
+                        sizes[p] += bag.draw(rng, racks[p] + sizes[p], RACKSIZE - sizes[p]);
+                        if ( sizes[p] == 0 ) {
+                            break;
+                        }
+                    }
+                }
+            }));
+        }
+        for ( std::thread &t : pool ) {
+            t.join();
+        }
+
+        // the sum and count of the next turn's points for each leave
+        LeaveTable built;
+        std::vector<double> sum(built.entries(), 0);
+        std::vector<uint32_t> seen(built.entries(), 0);
+        double total = 0;
+        long long count = 0;
+        for ( const std::vector<std::pair<uint32_t, int>> &game : samples ) {
+            for ( const std::pair<uint32_t, int> &x : game ) {
+                sum[x.first] += x.second;
+                ++seen[x.first];
+                total += x.second;
+                ++count;
+            }
+        }
+        if ( count == 0 ) {
+            std::cout << "no samples" << std::endl;
+            return 1;
+        }
+        double mean = total / count;
+
+        // every leave the tiles allow, smallest kinds first
+        int counts[KINDS];
+        std::fill(counts, counts + KINDS, 0);
+        std::function<void(int, int, const std::function<void(size_t, int)>&)> every =
+                [&](int kind, int size, const std::function<void(size_t, int)> &visit) {
+            if ( kind == KINDS ) {
+                visit(built.index(counts), size);
+                return;
+            }
+            int most = std::min(this->alpha.at(kind == KINDS - 1 ? BLANK : static_cast<char>('A' + kind)).quantity,
+                                LeaveTable::MAXLEAVE - size);
+            for ( counts[kind] = 0; counts[kind] <= most; ++counts[kind] ) {
+                every(kind + 1, size + counts[kind], visit);
+            }
+            counts[kind] = 0;
+        };
+
+        // the estimate from the tiles: what keeping that many tiles is worth, and on top of it what
+        // each tile is worth, the rest of every sample shared out over the tiles kept
+        double bySize[LeaveTable::MAXLEAVE + 1] = {0}, ofSize[LeaveTable::MAXLEAVE + 1] = {0};
+        every(0, 0, [&](size_t i, int size) {
+            bySize[size] += sum[i] - seen[i] * mean;
+            ofSize[size] += seen[i];
+        });
+        for ( int size = 0; size <= LeaveTable::MAXLEAVE; ++size ) {
+            bySize[size] = ofSize[size] > 0 ? bySize[size] / ofSize[size] : 0;
+        }
+
+        double credit[KINDS] = {0}, copies[KINDS] = {0};
+        every(0, 0, [&](size_t i, int size) {
+            if ( size == 0 || seen[i] == 0 ) {
+                return;
+            }
+            double residual = sum[i] - seen[i] * (mean + bySize[size]);
+            for ( int t = 0; t < KINDS; ++t ) {
+                credit[t] += counts[t] * residual / size;
+                copies[t] += counts[t] * static_cast<double>(seen[i]);
+            }
+        });
+        double tile[KINDS];
+        for ( int t = 0; t < KINDS; ++t ) {
+            tile[t] = copies[t] > 0 ? credit[t] / copies[t] : 0;
+        }
+
+        size_t distinct = 0;
+        every(0, 0, [&](size_t i, int size) {
+            double prior = bySize[size];
+            for ( int t = 0; t < KINDS; ++t ) {
+                prior += counts[t] * tile[t];
+            }
+            distinct += seen[i] > 0 ? 1 : 0;
+            built.set(i, static_cast<float>((sum[i] - seen[i] * mean + PRIOR * prior) / (seen[i] + PRIOR)));
+        });
+
+        if ( !built.save(file, games, count) ) {
+            return 1;
+        }
+
+        std::vector<std::pair<double, char>> order;
+        for ( int t = 0; t < KINDS; ++t ) {
+            order.push_back(std::make_pair(tile[t], t == KINDS - 1 ? BLANK : static_cast<char>('A' + t)));
+        }
+        std::sort(order.rbegin(), order.rend());
+        std::cout << "TILES:";
+        for ( const std::pair<double, char> &o : order ) {
+            char v[32];
+            std::snprintf(v, sizeof(v), " %c %+.1f", o.second, o.first);
+            std::cout << v;
+        }
+        std::cout << std::endl;
 
-                totalPoints = this->alpha.find(w[4])->second.points * 2;
-                for ( unsigned long i = 0 ; i < w.size(); ++i)
-                    this->b[this->dwRow][this->dwCol+i] = w[i];
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        std::cout << "BUILT:" << file << " " << games << " games " << count << " samples " << distinct
+                  << " leaves seen, next turn " << mean << " points, " << secs << " seconds" << std::endl;
+        return 0;
+    }
+
+    /**
+     * check the fast paths against brute force
+     * plays random games with short racks and compares every position's move set with the moves
+     * brute force finds, and every move's score with the score worked out from scratch,
+     * then compares the anagram index with a scan of the whole dictionary for full racks
+     * blanks are drawn far more often than in a real bag, they are what this is after
+     * @param games
+     * @param seed
+     * @return int exit code
+     */
+    int selfCheck(int games, unsigned int seed) {
 
-                this->startingSquare = std::to_string(this->dwRow) + "," + std::to_string(this->dwCol);
+        std::mt19937 mt(seed);
+        std::string pool;
+        for ( auto it = this->alpha.begin(); it != this->alpha.end(); ++it ) {
+            pool.append(it->first == BLANK ? 8 * it->second.quantity : it->second.quantity, it->first);
+        }
+        std::uniform_int_distribution<size_t> pick(0, pool.size() - 1);
 
+        long long positions = 0, moves = 0, racks = 0, words = 0, mismatches = 0;
+        auto mismatch = [&mismatches](const std::string &what) {
+            if ( mismatches++ < 10 ) {
+                std::cout << "MISMATCH:" << what << std::endl;
             }
-            totalPoints += this->bestWords.rbegin()->first * 2;
+        };
 
+        // moves: the short racks keep brute force affordable
+        for ( int g = 0; g < games; ++g ) {
 
-            std::cout << "RACK:" << this->rack << std::endl ;
-            std::cout << "PLACE WORD " << w << " " << this->startingSquare << " "<< totalPoints << std::endl;
-            std::cout << "ELAPSED TIME:" << this->elapsed_secs << " seconds" << std::endl;
+            char board[LEN][LEN];
+            std::memset(board, 0, sizeof(board));
+            for ( int turn = 0; turn < 10; ++turn ) {
 
+                std::string rack;
+                for ( int t = 2 + static_cast<int>(mt() % 3); t > 0; --t ) {
+                    rack += pool[pick(mt)];
+                }
+                if ( std::count(rack.begin(), rack.end(), BLANK) > 1 ) {
+                    rack.resize(std::min<size_t>(rack.size(), 3));
+                }
 
-            // from the bag
-            //std::cout << "PLACE WORD " << this->bestWords.rbegin()->second << " Points " << this->bestWords.rbegin()->first << std::endl;
+                std::set<std::string> generated;
+                std::vector<move> found;
+                this->generator.generate(board, rack, [&](const move &m) { found.push_back(m); });
+                for ( const move &m : found ) {
+                    if ( !generated.insert(placement(m)).second ) {
+                        mismatch(rack + " " + m.word + " found twice");
+                    }
+                    if ( this->generator.score(board, m) != m.score ) {
+                        mismatch(rack + " " + m.word + " scored " + std::to_string(m.score) + " instead of " +
+                                 std::to_string(this->generator.score(board, m)));
+                    }
+                }
 
+                // an opening is only reported across, the down copy is the same move
+                bool empty = true;
+                for ( int r = 0; r < LEN; ++r ) {
+                    for ( int c = 0; c < LEN; ++c ) {
+                        empty = empty && board[r][c] == '\0';
+                    }
+                }
+                std::set<std::string> expected;
+                char after[LEN][LEN];
+                int squares[RACKSIZE][2];
+                std::memcpy(after, board, sizeof(after));
+                for ( int d = 0; d < (empty ? 1 : 2); ++d ) {
+                    for ( int r = 0; r < LEN; ++r ) {
+                        for ( int c = 0; c < LEN; ++c ) {
+                            if ( !board[r][c] ) {
+                                this->layAll(board, after, rack, r, c, d, 1 - d, squares, 0, expected);
+                            }
+                        }
+                    }
+                }
+                for ( const std::string &k : expected ) {
+                    if ( !generated.count(k) ) {
+                        mismatch(rack + " missed " + k);
+                    }
+                }
+                for ( const std::string &k : generated ) {
+                    if ( !expected.count(k) ) {
+                        mismatch(rack + " not legal " + k);
+                    }
+                }
 
-            this->bestWords.clear();
-            totalPoints = 0;
-            this->startingSquare.clear();
-            w.clear();
+                ++positions;
+                moves += found.size();
+                if ( !found.empty() ) {
+                    const move &m = found[mt() % found.size()];
+                    for ( int i = 0; i < m.length; ++i ) {
+                        if ( m.placed & (1u << i) ) {
+                            board[m.across ? m.row : m.row + i][m.across ? m.col + i : m.col] = m.word[i];
+                        }
+                    }
+                }
+            }
         }
 
+        // rack words: every cover of every word once, and the same words a scan of the dictionary finds
+        std::vector<std::string> all;
+        std::function<void(uint32_t, std::string &)> walk = [&](uint32_t n, std::string &w) {
+            if ( w.size() >= 2 && this->sowpods.isWord(n) ) {
+                all.push_back(w);
+            }
+            if ( w.size() == RACKSIZE ) {
+                return;
+            }
+            for ( uint32_t e = this->sowpods.edges(n); e != 0; e &= e - 1 ) {
+                char c = static_cast<char>('A' + __builtin_ctz(e));
+                w += c;
+                walk(this->sowpods.next(n, c), w);
+                w.pop_back();
+            }
+        };
+        std::string w;
+        walk(this->sowpods.root(), w);
+
+        for ( int i = 0; i < games * 20; ++i ) {
 
+            std::string rack;
+            for ( int t = 0; t < RACKSIZE; ++t ) {
+                rack += pool[pick(mt)];
+            }
+            if ( std::count(rack.begin(), rack.end(), BLANK) > 2 ) {
+                continue;
+            }
 
+            std::set<std::string> covers, got;
+            this->anagrams.anagrams(rack, [&](uint64_t packed, int len, const int *blankUse) {
+                char word[RACKSIZE + 1];
+                AnagramIndex::unpack(packed, len, word);
+                std::string k(word, len);
+                got.insert(k);
+                for ( int c = 0; c < 26; ++c ) {
+                    k.append(blankUse[c], static_cast<char>('a' + c));
+                }
+                if ( !covers.insert(k).second ) {
+                    mismatch(rack + " cover " + k + " twice");
+                }
+            });
 
+            int counts[27] = {0};
+            for ( char c : rack ) {
+                ++counts[c == BLANK ? 26 : c - 'A'];
+            }
+            for ( const std::string &a : all ) {
+                int left[27], short_ = 0;
+                std::copy(counts, counts + 27, left);
+                for ( char c : a ) {
+                    if ( left[c - 'A'] > 0 ) {
+                        --left[c - 'A'];
+                    } else {
+                        ++short_;
+                    }
+                }
+                if ( ( short_ <= counts[26] ) != ( got.count(a) > 0 ) ) {
+                    mismatch(rack + " " + a);
+                }
+            }
+            ++racks;
+            words += covers.size();
+        }
 
+        std::cout << "SELFCHECK:" << games << " games " << positions << " positions " << moves << " moves "
+                  << racks << " racks " << words << " rack words " << mismatches << " mismatches" << std::endl;
+        return mismatches == 0 ? 0 : 1;
     }
 
-};
+private:
 
-int main() {
+    // declared after alpha, it takes its points from there
+    MoveGenerator generator;
 
-    Board* s = new Board();
+};
+
+/**
+ * compile the word list into the images the board maps at start up
+ * @param words word list
+ * @param image dictionary image to write
+ * @param anagramImage anagram index image to write
+ * @return int exit code
+ */
+int compileDictionary(const std::string &words, const std::string &image, const std::string &anagramImage) {
 
-    s->stats();
+    std::clock_t begin = clock();
 
+    Dictionary d;
+    if ( !d.load(words) || !d.save(image, Dictionary::fileSize(words)) ) {
+        return 1;
+    }
 
+    std::cout << "COMPILED:" << words << " -> " << image << " " << d.words() << " words " << d.size() << " states "
+              << d.bytes() << " bytes " << double(clock() - begin) / CLOCKS_PER_SEC << " seconds" << std::endl;
 
+    begin = clock();
+    AnagramIndex a;
+    a.build(d, RACKSIZE);
+    if ( !a.save(anagramImage, Dictionary::fileSize(words)) ) {
+        return 1;
+    }
 
+    std::cout << "COMPILED:" << words << " -> " << anagramImage << " " << a.size() << " words " << a.groups()
+              << " signatures " << double(clock() - begin) / CLOCKS_PER_SEC << " seconds" << std::endl;
+    return 0;
+}
 
+/**
+ * answer one dictionary question without setting up a board
+ * the words come one a line as the walk finds them, then their count
+ * @param kind pattern, prefix, anagram or hooks
+ * @param letters what to ask about
+ * @param useImage map the compiled dictionary image when there is a good one
+ * @return int exit code
+ */
+int queryDictionary(const std::string &kind, const std::string &letters, bool useImage) {
 
+    Dictionary d;
+    if ( !( useImage && d.map(IMAGEFILE, Dictionary::fileSize(WORDFILE)) ) && !d.load(WORDFILE) ) {
+        return 1;
+    }
 
+    if ( kind == "hooks" ) {
+
+        std::string word = letters;
+        std::transform(word.begin(), word.end(), word.begin(), [](char c) {
+            return static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        });
+        uint32_t front = d.frontHooks(word), back = d.backHooks(word);
+        std::string f, b;
+        for ( int i = 0; i < 26; ++i ) {
+            f += ( front & (1u << i) ) ? static_cast<char>('A' + i) : '\0';
+            b += ( back & (1u << i) ) ? static_cast<char>('A' + i) : '\0';
+        }
+        f.erase(std::remove(f.begin(), f.end(), '\0'), f.end());
+        b.erase(std::remove(b.begin(), b.end(), '\0'), b.end());
+        std::cout << "FRONT HOOKS:" << f << std::endl;
+        std::cout << "BACK HOOKS:" << b << std::endl;
+        return 0;
+    }
 
+    WordQuery q = kind == "pattern" ? d.pattern(letters) : kind == "prefix" ? d.prefix(letters) : d.anagram(letters);
+    size_t n = 0;
+    for ( const std::string &w : q ) {
+        std::cout << w << '\n';
+        ++n;
+    }
+    std::cout << "WORDS:" << n << std::endl;
     return 0;
 }
 
+int main(int argc, char* argv[]) {
+
+    bool compile = false;
+    bool play = false;
+    std::string batch;
+    int selfCheck = 0;
+    int simulate = 0;
+    int candidates = 10;
+    int top = 1;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    int draw = 0;
+    unsigned int seed = std::random_device()();
+    bool useImage = true;
+    std::string leaves;
+    int buildLeaves = 0;
+    std::string query, queryLetters;
+    for (int i = 1; i < argc; ++i) {
+
+        std::string arg = argv[i];
+        if ( arg == "--compile" ) {
+            compile = true;
+        } else if ( arg == "--play" ) {
+            play = true;
+        } else if ( arg == "--batch" ) {
+            batch = "-";
+        } else if ( arg.compare(0, 8, "--batch=") == 0 && arg.size() > 8 ) {
+            batch = arg.substr(8);
+        } else if ( arg == "--selfcheck" ) {
+            selfCheck = 20;
+        } else if ( arg.compare(0, 12, "--selfcheck=") == 0 && std::atoi(arg.c_str() + 12) > 0 ) {
+            selfCheck = std::atoi(arg.c_str() + 12);
+        } else if ( arg == "--simulate" ) {
+            simulate = 1000;
+        } else if ( arg.compare(0, 11, "--simulate=") == 0 && std::atoi(arg.c_str() + 11) > 0 ) {
+            simulate = std::atoi(arg.c_str() + 11);
+        } else if ( arg.compare(0, 13, "--candidates=") == 0 && std::atoi(arg.c_str() + 13) > 0 ) {
+            candidates = std::atoi(arg.c_str() + 13);
+        } else if ( arg.compare(0, 6, "--top=") == 0 && std::atoi(arg.c_str() + 6) > 0 ) {
+            top = std::atoi(arg.c_str() + 6);
+        } else if ( arg.compare(0, 10, "--threads=") == 0 && std::atoi(arg.c_str() + 10) > 0 ) {
+            threads = std::atoi(arg.c_str() + 10);
+        } else if ( arg.compare(0, 7, "--draw=") == 0 && std::atoi(arg.c_str() + 7) > 0 ) {
+            draw = std::atoi(arg.c_str() + 7);
+        } else if ( arg.compare(0, 7, "--seed=") == 0 ) {
+            seed = std::strtoul(arg.c_str() + 7, nullptr, 10);
+        } else if ( arg == "--leaves" ) {
+            leaves = LEAVEFILE;
+        } else if ( arg.compare(0, 9, "--leaves=") == 0 && arg.size() > 9 ) {
+            leaves = arg.substr(9);
+        } else if ( arg == "--build-leaves" ) {
+            buildLeaves = 1000;
+        } else if ( arg.compare(0, 15, "--build-leaves=") == 0 && std::atoi(arg.c_str() + 15) > 0 ) {
+            buildLeaves = std::atoi(arg.c_str() + 15);
+        } else if ( arg.compare(0, 10, "--pattern=") == 0 || arg.compare(0, 9, "--prefix=") == 0 ||
+                    arg.compare(0, 10, "--anagram=") == 0 || arg.compare(0, 8, "--hooks=") == 0 ) {
+            query = arg.substr(2, arg.find('=') - 2);
+            queryLetters = arg.substr(arg.find('=') + 1);
+        } else if ( arg == "--text" ) {
+            useImage = false;
+        } else {
+            std::cout << "usage: scrabble [--text] [--leaves[=file]] [--play | --draw=N [--seed=S]] [--top=K]" << std::endl <<
+                      "       scrabble --simulate[=racks] [--candidates=K] [--threads=N] [--seed=S]" << std::endl <<
+                      "       scrabble --batch[=file] [--leaves[=file]] [--threads=N] [--top=K]" << std::endl <<
+                      "       scrabble --build-leaves[=games] [--leaves[=file]] [--threads=N] [--seed=S]" << std::endl <<
+                      "       scrabble [--text] --pattern=?A?E | --prefix=QU | --anagram=AEIRST? | --hooks=WORD" << std::endl <<
+                      "       scrabble --compile" << std::endl <<
+                      "       scrabble --selfcheck[=games] [--seed=S]" << std::endl;
+            return 1;
+        }
+    }
+
+    if ( compile ) {
+
+        return compileDictionary(WORDFILE, IMAGEFILE, ANAGRAMFILE);
+    }
+
+    if ( !query.empty() ) {
+
+        return queryDictionary(query, queryLetters, useImage);
+    }
+
+    Board* s = new Board(useImage);
+
+    int status = 0;
+    // a table to build does not have to be there yet, one that is there plays the games
+    if ( !leaves.empty() && ( buildLeaves == 0 || Dictionary::fileSize(leaves) > 0 ) && !s->loadLeaves(leaves) &&
+         buildLeaves == 0 ) {
+        status = 1;
+    } else if ( buildLeaves > 0 ) {
+        std::cout << "SEED:" << seed << std::endl;
+        status = s->buildLeaves(buildLeaves, threads, seed, leaves.empty() ? LEAVEFILE : leaves);
+    } else if ( selfCheck > 0 ) {
+        std::cout << "SEED:" << seed << std::endl;
+        status = s->selfCheck(selfCheck, seed);
+    } else if ( !batch.empty() ) {
+        status = s->batch(batch, threads, top);
+    } else if ( simulate > 0 ) {
+        std::cout << "SEED:" << seed << std::endl;
+        s->simulate(simulate, candidates, threads, seed);
+    } else if ( play ) {
+        s->play(top);
+    } else {
+        s->stats(draw, seed, top);
+    }
+
+    delete s;
+
+    return status;
+}
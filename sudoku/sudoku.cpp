@@ -4,280 +4,4198 @@
  *
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <dirent.h>
+#include <fcntl.h>
 #include <fstream>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
 //#include <set>
 
 /**
- * overall game board length
+ * character indicating that the position is not filled
+ */
+const char NOTFILLED = '-';
+
+/**
+ * engines available to solve the puzzle
+ * SCAN rescans the row, column and sub board for every candidate
+ * MASK keeps occupancy bit sets of the three constraints up to date
+ * DLX solves the exact cover form of the puzzle with Dancing Links
+ * ITER is the MASK search on an explicit stack instead of recursion
+ */
+enum engine { SCAN, MASK, DLX, ITER };
+
+/**
+ * how the MASK engine picks the next cell to fill
+ * FIRST takes the top left empty cell, like isNotFilled()
+ * MRV takes the cell with the fewest candidates, ties go to the cell
+ * with the most empty cells on its three constraints
+ */
+enum heuristic { FIRST, MRV };
+
+/**
+ *  hold the metrics
+ */
+struct metrics {
+    int stackHeight = -1;
+    int maxStackHeight = -1;
+    int backtracked = 0;
+    int iterations = 0;
+
+    // hits of the propagation rules, only used by the MASK engine
+    bool propagation = false;
+    int nakedSingles = 0;
+    int hiddenSingles = 0;
+    int nakedPairs = 0;
+    int hiddenPairs = 0;
+    int pointing = 0;
+    int claiming = 0;
+};
+
+/**
+ * how to solve, as given on the command line
+ */
+struct options {
+    engine e = SCAN;
+    heuristic h = FIRST;
+    bool rules = false;
+
+    // solutions to look for, 0 counts them all; SCAN stops at the first
+    long long limit = 1;
+
+    // nodes the ITER engine visits before it pauses, 0 runs to the end
+    long long slice = 0;
+
+    // the ITER engine runs only the singles of the rules, for the generator
+    // whose uniqueness checks spend more on pairs and lines than they save
+    bool singlesOnly = false;
+};
+
+/**
+ * the extra rules of a puzzle, as read after its grid
+ * diagonal : both long diagonals hold every symbol once, X-sudoku
+ * region : the box of every cell for jigsaw puzzles, empty for the usual boxes
+ * cages : killer cages, their cells hold different symbols adding up to sum,
+ *         the i-th symbol counts as i + 1
+ */
+struct variant {
+
+    struct cage {
+        int sum;
+        std::vector<int> cells;
+    };
+
+    bool diagonal = false;
+    std::vector<int> region;
+    std::vector<cage> cages;
+
+    bool empty() const {
+
+        return !diagonal && region.empty() && cages.empty();
+    }
+};
+
+/**
+ * fold the metrics of one solve into a running total
+ * the stack height is the deepest seen, everything else adds up
+ * @param total running total
+ * @param m metrics of one solve
+ */
+void accumulate(metrics &total, const metrics &m)
+{
+    total.maxStackHeight = std::max(total.maxStackHeight, m.maxStackHeight);
+    total.backtracked += m.backtracked;
+    total.iterations += m.iterations;
+    total.propagation = total.propagation || m.propagation;
+    total.nakedSingles += m.nakedSingles;
+    total.hiddenSingles += m.hiddenSingles;
+    total.nakedPairs += m.nakedPairs;
+    total.hiddenPairs += m.hiddenPairs;
+    total.pointing += m.pointing;
+    total.claiming += m.claiming;
+}
+
+/**
+ * Print the metrics
+ * @param m metrics
+ */
+void printMetrics(const metrics &m)
+{
+    std::cout << " Metrics " << " |  Nodes : " << m.iterations <<
+              " | Backtracked : " << m.backtracked <<
+              " | MaxStackHeight : " << m.maxStackHeight;
+
+    if ( m.propagation ) {
+
+        std::cout << std::endl << " Rules " << " |  NakedSingles : " << m.nakedSingles <<
+                  " | HiddenSingles : " << m.hiddenSingles <<
+                  " | NakedPairs : " << m.nakedPairs <<
+                  " | HiddenPairs : " << m.hiddenPairs <<
+                  " | Pointing : " << m.pointing <<
+                  " | Claiming : " << m.claiming;
+    }
+}
+
+/**
+ * bit counting for both widths of mask_t
+ */
+inline int popcount(unsigned int x) { return __builtin_popcount(x); }
+inline int popcount(unsigned long long x) { return __builtin_popcountll(x); }
+inline int ctz(unsigned int x) { return __builtin_ctz(x); }
+inline int ctz(unsigned long long x) { return __builtin_ctzll(x); }
+
+/**
+ * candidates of a whole row of cells at once, for the boards whose masks fit 32 bits
+ * cand[c] = ~(row | col[c] | box[c] | removed[c]) & all and count[c] is its popcount,
+ * box holds the box mask of each column of the row
+ * the vector kernels do 4 or 8 columns per step and count with a nibble table
+ */
+typedef void (*candidateKernel)(unsigned int row, const unsigned int *col, const unsigned int *box,
+                                const unsigned int *removed, unsigned int all, int len,
+                                unsigned int *cand, int *count);
+
+/**
+ * the plain loop, used where there is nothing better and for the columns
+ * left over after the vector kernels
+ */
+void candidatesScalar(unsigned int row, const unsigned int *col, const unsigned int *box,
+                      const unsigned int *removed, unsigned int all, int len,
+                      unsigned int *cand, int *count)
+{
+    for ( int c = 0; c < len; ++c ) {
+
+        cand[c] = ~(row | col[c] | box[c] | removed[c]) & all;
+        count[c] = popcount(cand[c]);
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * 4 columns per step
+ */
+__attribute__((target("sse4.2")))
+void candidatesSse4(unsigned int row, const unsigned int *col, const unsigned int *box,
+                    const unsigned int *removed, unsigned int all, int len,
+                    unsigned int *cand, int *count)
+{
+    const __m128i nibbles = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m128i low = _mm_set1_epi8(0x0f);
+    const __m128i ones8 = _mm_set1_epi8(1);
+    const __m128i ones16 = _mm_set1_epi16(1);
+    const __m128i taken = _mm_set1_epi32(row);
+    const __m128i mask = _mm_set1_epi32(all);
+
+    int c = 0;
+    for ( ; c + 4 <= len; c += 4 ) {
+
+        __m128i v = _mm_or_si128(taken, _mm_loadu_si128((const __m128i *) (col + c)));
+        v = _mm_or_si128(v, _mm_loadu_si128((const __m128i *) (box + c)));
+        v = _mm_or_si128(v, _mm_loadu_si128((const __m128i *) (removed + c)));
+        v = _mm_andnot_si128(v, mask);
+        _mm_storeu_si128((__m128i *) (cand + c), v);
+
+        // bits per byte, then bytes summed up to each 32 bit lane
+        __m128i n = _mm_add_epi8(_mm_shuffle_epi8(nibbles, _mm_and_si128(v, low)),
+                                 _mm_shuffle_epi8(nibbles, _mm_and_si128(_mm_srli_epi16(v, 4), low)));
+        n = _mm_madd_epi16(_mm_maddubs_epi16(n, ones8), ones16);
+        _mm_storeu_si128((__m128i *) (count + c), n);
+    }
+
+    candidatesScalar(row, col + c, box + c, removed + c, all, len - c, cand + c, count + c);
+}
+
+/**
+ * 8 columns per step
+ */
+__attribute__((target("avx2")))
+void candidatesAvx2(unsigned int row, const unsigned int *col, const unsigned int *box,
+                    const unsigned int *removed, unsigned int all, int len,
+                    unsigned int *cand, int *count)
+{
+    const __m256i nibbles = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                             0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    const __m256i ones8 = _mm256_set1_epi8(1);
+    const __m256i ones16 = _mm256_set1_epi16(1);
+    const __m256i taken = _mm256_set1_epi32(row);
+    const __m256i mask = _mm256_set1_epi32(all);
+
+    int c = 0;
+    for ( ; c + 8 <= len; c += 8 ) {
+
+        __m256i v = _mm256_or_si256(taken, _mm256_loadu_si256((const __m256i *) (col + c)));
+        v = _mm256_or_si256(v, _mm256_loadu_si256((const __m256i *) (box + c)));
+        v = _mm256_or_si256(v, _mm256_loadu_si256((const __m256i *) (removed + c)));
+        v = _mm256_andnot_si256(v, mask);
+        _mm256_storeu_si256((__m256i *) (cand + c), v);
+
+        __m256i n = _mm256_add_epi8(_mm256_shuffle_epi8(nibbles, _mm256_and_si256(v, low)),
+                                    _mm256_shuffle_epi8(nibbles, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+        n = _mm256_madd_epi16(_mm256_maddubs_epi16(n, ones8), ones16);
+        _mm256_storeu_si256((__m256i *) (count + c), n);
+    }
+
+    candidatesScalar(row, col + c, box + c, removed + c, all, len - c, cand + c, count + c);
+}
+
+#endif
+
+/**
+ * the best kernel the cpu runs, or the one asked for by name
+ * @param name "avx2", "sse4", "scalar" or empty for the best one
+ * @return candidateKernel nullptr if the cpu can not run the one asked for
+ */
+candidateKernel chooseKernel(const std::string &name)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    bool avx2 = __builtin_cpu_supports("avx2");
+    bool sse4 = __builtin_cpu_supports("sse4.2");
+
+    if ( name == "avx2" || ( name.empty() && avx2 ) ) {
+
+        return avx2 ? candidatesAvx2 : nullptr;
+    }
+
+    if ( name == "sse4" || ( name.empty() && sse4 ) ) {
+
+        return sse4 ? candidatesSse4 : nullptr;
+    }
+#endif
+
+    return name.empty() || name == "scalar" ? candidatesScalar : nullptr;
+}
+
+/**
+ * the kernel MRV uses on the 16x16 and 25x25 boards, picked once at start up
+ */
+candidateKernel candidates = chooseKernel("");
+
+/**
+ * candidates of a whole row for both widths of mask_t, the 64 bit masks
+ * of the 36x36 board have no kernel and take the plain loop
+ * though MRV leaves that board to candidatesOf()
+ */
+inline void rowCandidates(unsigned int row, const unsigned int *col, const unsigned int *box,
+                          const unsigned int *removed, unsigned int all, int len,
+                          unsigned int *cand, int *count)
+{
+    candidates(row, col, box, removed, all, len, cand, count);
+}
+
+inline void rowCandidates(unsigned long long row, const unsigned long long *col, const unsigned long long *box,
+                          const unsigned long long *removed, unsigned long long all, int len,
+                          unsigned long long *cand, int *count)
+{
+    for ( int c = 0; c < len; ++c ) {
+
+        cand[c] = ~(row | col[c] | box[c] | removed[c]) & all;
+        count[c] = popcount(cand[c]);
+    }
+}
+
+/**
+ * the puzzle of one order, SUBLEN x SUBLEN sub boards of SUBLEN x SUBLEN cells
+ * every size gets its own instance so the board and all the bit sets are
+ * fixed size arrays and the loops over LEN have a constant trip count
+ */
+template <int SUBLEN>
+class Sudoku {
+
+public:
+
+    /**
+     * overall game board length
+     */
+    static constexpr int LEN = SUBLEN * SUBLEN;
+
+    /**
+     * one bit per symbol, bit i is set when SYM[i] is taken
+     */
+    typedef typename std::conditional<(LEN > 32), unsigned long long, unsigned int>::type mask_t;
+
+    /**
+     * every symbol taken
+     */
+    static constexpr mask_t ALL = (mask_t(1) << LEN) - 1;
+
+    /**
+     * MRV counts the candidates of the whole board a row at a time with the
+     * candidate kernel instead of one empty cell at a time, which pays off
+     * on the 16x16 and 25x25 boards where the rows fill the vectors
+     * the 36x36 masks are too wide for the kernels
+     */
+    static constexpr bool VECTOR = LEN >= 16 && LEN <= 32;
+
+    /**
+     * symbols used are unique -- digits for 4x4 and 9x9,
+     * hex values for 16x16 carried on through the alphabet for the larger boards
+     */
+    static constexpr const char *SYM =
+            SUBLEN == 2 ? "1234" :
+            SUBLEN == 3 ? "123456789" :
+            "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+    /**
+     * occupancy of the three constraints, kept in step with the board
+     * box is numbered left to right, top to bottom
+     */
+    struct occupancy {
+        mask_t row[LEN];
+        mask_t col[LEN];
+        mask_t box[LEN];
+
+        // houses of the variants, the two diagonals then the cages,
+        // and the sum and count of the symbols placed in each cage
+        mask_t extra[2 + LEN * LEN];
+        int cageSum[LEN * LEN];
+        int cageFilled[LEN * LEN];
+    };
+
+    /**
+     * empty cells of the board, numbered r * LEN + c
+     * cells [0, count) are still empty, filling a cell moves it to
+     * position count - 1 and shrinks the range, undoing grows it back
+     * pos is the position of each cell in the list
+     */
+    struct emptyCells {
+        int cell[LEN * LEN];
+        int pos[LEN * LEN];
+        int count;
+    };
+
+    /**
+     * one level of the explicit stack of the ITER engine
+     * cell is the cell branched on and cand the candidates not tried yet
+     * placedMark and trailMark are where the grid stood before the rules
+     * ran at this level, branchPlaced and branchTrail where it stood
+     * just before the branch move
+     */
+    struct frame {
+        int cell;
+        mask_t cand;
+        int placedMark;
+        int trailMark;
+        int branchPlaced;
+        int branchTrail;
+    };
+
+    /**
+     * everything the MASK engine knows about the board
+     * removed holds the candidates taken away by the propagation rules
+     * on top of what the occupancy already rules out
+     * placed and trail record every move and removal, in order,
+     * so a backtrack undoes them by popping back to a mark
+     */
+    struct grid {
+        occupancy o;
+        emptyCells ec;
+        mask_t removed[LEN * LEN];
+        int placed[LEN * LEN];
+        int placedSym[LEN * LEN];
+        int placedTop;
+        int trailCell[LEN * LEN * LEN];
+        mask_t trailMask[LEN * LEN * LEN];
+        int trailTop;
+
+        // explicit stack of the ITER engine, enterNext is set when the
+        // next step goes down into a new node rather than back to stack[top - 1]
+        frame stack[LEN * LEN + 1];
+        int top;
+        bool enterNext;
+    };
+
+    /**
+     * exact cover form of the puzzle for Dancing Links
+     * a candidate row is cell * LEN + i for SYM[i] on the cell, it covers
+     * the cell, SYM[i] in the row, SYM[i] in the column and SYM[i] in the sub board
+     * all nodes live in one flat pool and every link is an index into it
+     * node 0 is the root, 1 .. COLS are the column headers and the four
+     * nodes of candidate row k are the block starting at 1 + COLS + 4 * k
+     */
+    struct dlx {
+        static const int COLS = 4 * LEN * LEN;
+        static const int ROWS = LEN * LEN * LEN;
+        static const int NODES = 1 + COLS + 4 * ROWS;
+
+        int left[NODES];
+        int right[NODES];
+        int up[NODES];
+        int down[NODES];
+        int col[NODES];
+        int size[1 + COLS];
+
+        // candidate rows on the current path, found counts complete covers
+        int path[LEN * LEN];
+        int depth;
+        long long found;
+    };
+
+    // array storing the puzzle
+    char b[LEN][LEN];
+
+    // metrics of the last solve
+    metrics m;
+
+    // times the ITER engine paused in the last solve
+    int pauses = 0;
+
+    // solutions the last solve found, and the first of them as one line
+    long long found = 0;
+    std::string first;
+
+    // the parallel search shares the solution count and a stop flag
+    // across the workers, the MASK engine bumps the one and watches the other
+    std::atomic<long long> *sharedFound = nullptr;
+    std::atomic<bool> *stop = nullptr;
+
+    Sudoku() {
+
+        setVariant(variant());
+    }
+
+    /**
+     * compile the extra rules of a variant into the engine tables, the
+     * boxes of a jigsaw replace the usual ones and every diagonal or cage
+     * becomes one more bit set the cell's candidates are masked with
+     * only the MASK and ITER engines know about them
+     * @param v the variant, an empty one goes back to the plain puzzle
+     */
+    void setVariant(const variant &v) {
+
+        if ( v.empty() && !hasVariant && houses != 0 ) {
+
+            return;
+        }
+
+        hasVariant = !v.empty();
+        jigsaw = !v.region.empty();
+        houses = v.diagonal ? 3 * LEN + 2 : 3 * LEN;
+        for (int cell = 0; cell < LEN * LEN; ++cell) {
+
+            int r = cell / LEN, c = cell % LEN;
+            region[cell] = jigsaw ? v.region[cell] : (r / SUBLEN) * SUBLEN + c / SUBLEN;
+            extraCount[cell] = 0;
+            cageOf[cell] = -1;
+        }
+
+        if ( v.diagonal ) {
+
+            for (int j = 0; j < LEN; ++j) {
+
+                int down = j * LEN + j, up = j * LEN + LEN - 1 - j;
+                extraOf[down][extraCount[down]++] = 0;
+                extraOf[up][extraCount[up]++] = 1;
+            }
+        }
+
+        for (unsigned int k = 0; k < v.cages.size(); ++k) {
+
+            cageTarget[k] = v.cages[k].sum;
+            cageSize[k] = v.cages[k].cells.size();
+            for (unsigned int j = 0; j < v.cages[k].cells.size(); ++j) {
+
+                int cell = v.cages[k].cells[j];
+                cageOf[cell] = k;
+                extraOf[cell][extraCount[cell]++] = 2 + k;
+            }
+        }
+        cages = v.cages.size();
+
+        initHouses();
+    }
+
+    /**
+     * copy the puzzle onto the board and reset the metrics
+     * @param rows LEN rows of LEN characters, NOTFILLED or a symbol
+     * @return bool false if a character is neither
+     */
+    bool load(const std::vector<std::string> &rows) {
+
+        std::string line;
+        for (int r = 0; r < LEN; ++r) {
+
+            line += rows[r];
+        }
+
+        return load(line);
+    }
+
+    /**
+     * copy the puzzle onto the board and reset the metrics
+     * @param line LEN * LEN characters, row after row, NOTFILLED or a symbol
+     * @return bool false if a character is neither
+     */
+    bool load(const std::string &line) {
+
+        return load(line.data());
+    }
+
+    /**
+     * copy the puzzle onto the board and reset the metrics
+     * @param line LEN * LEN characters, row after row, NOTFILLED or a symbol
+     * @return bool false if a character is neither
+     */
+    bool load(const char *line) {
+
+        for (int r = 0; r < LEN; ++r) {
+            for (int c = 0; c < LEN; ++c) {
+
+                char v = line[r * LEN + c];
+                if ( v != NOTFILLED && symIndex(v) < 0 ) {
+
+                    return false;
+                }
+                b[r][c] = v;
+            }
+        }
+
+        m = metrics();
+        pauses = 0;
+        found = 0;
+        first.clear();
+        return true;
+    }
+
+private:
+
+    /**
+     * the constraints as lists of cells
+     * 0 .. LEN-1 are the rows, then the columns, then the sub boards,
+     * then the two diagonals when the variant has them
+     */
+    int house[3 * LEN + 2][LEN];
+    int houses = 0;
+
+    // the variant as setVariant() compiled it : the box of every cell,
+    // the extra houses of every cell, and the cage of every cell with
+    // the sum and size of every cage
+    bool hasVariant = false;
+    bool jigsaw = false;
+    int region[LEN * LEN];
+    int extraOf[LEN * LEN][3];
+    int extraCount[LEN * LEN];
+    int cageOf[LEN * LEN];
+    int cageTarget[LEN * LEN];
+    int cageSize[LEN * LEN];
+    int cages = 0;
+
+    // engine state, allocated on first use and reused for the next puzzle
+    std::unique_ptr<grid> state;
+    std::unique_ptr<dlx> matrix;
+
+    /**
+     * Iterate through the sub board and check for the value
+     * Helper Function
+     * @param subR sub board row
+     * @param subC sub board column
+     * @param v value
+     * @return bool
+     */
+    bool inSubBoard(int subR, int subC, char v)
+    {
+        for (int r = 0; r < SUBLEN; r++) {
+
+            for (int c = 0; c < SUBLEN; c++) {
+
+                if (b[r + subR][c + subC] == v) {
+
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * Iterate through the entire row of the board and check for the value
+     * Helper Function
+     * @param r row
+     * @param v value
+     * @return bool
+     */
+    bool inRow(int r, char v)
+    {
+        for (int c = 0; c < LEN; c++) {
+
+            if ( b[r][c] == v) {
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * Iterate through the entire column of the board and check for the value
+     * Helper Function
+     * @param c column
+     * @param v value
+     * @return bool
+     */
+    bool inColumn(int c, char v)
+    {
+        for (int r = 0; r < LEN; r++) {
+
+            if ( b[r][c] == v) {
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * Helps to identify the co-ordinate on the board that needs to be updated
+     * Helper Function
+     * @param r a reference to the row to maintain the right address during recursion
+     * @param c a reference to the column  to maintain the right address during recursion
+     * @return bool
+     */
+    bool isNotFilled(int &r, int &c)
+    {
+        for (r = 0; r < LEN; r++) {
+            for (c = 0; c < LEN; c++) {
+                if (b[r][c] == NOTFILLED) {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * check if the value is on the subBoard or the column or row of the co-ordinate r,c
+     * its legal if the value is not there on the three constraints
+     * Helper Function
+     * @param r row
+     * @param c column
+     * @param v value
+     * @return bool
+     */
+    bool isLegal(int r, int c, char v)
+    {
+
+        /**
+         *  (r  - r%SUBLEN, c - c%SUBLEN ) gives the top left of the Sub Board.
+         */
+
+        return
+                !inRow(r,v) &&
+                !inColumn(c,v) &&
+                !inSubBoard(r - r%SUBLEN, c - c%SUBLEN,v);
+    }
+
+    /**
+     * position of the symbol in SYM
+     * Helper Function
+     * @param v value
+     * @return index into SYM or -1 if v is not a symbol
+     */
+    int symIndex(char v)
+    {
+        for (int i = 0; i < LEN; ++i) {
+
+            if (SYM[i] == v) {
+
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    /**
+     * sub board number of the co-ordinate r,c, the jigsaw region on a jigsaw
+     * Helper Function
+     * @param r row
+     * @param c column
+     * @return int
+     */
+    int boxOf(int r, int c)
+    {
+        return region[r * LEN + c];
+    }
+
+    /**
+     * build the occupancy bit sets from the givens on the board
+     * Helper Function
+     * @param o occupancy to fill
+     * @return bool false if a given is repeated on one of the three constraints
+     */
+    bool initOccupancy(occupancy &o)
+    {
+        std::memset(&o, 0, sizeof(o));
+
+        for (int r = 0; r < LEN; ++r) {
+            for (int c = 0; c < LEN; ++c) {
+
+                int i = symIndex(b[r][c]);
+                if (i < 0) {
+                    continue;
+                }
+
+                mask_t bit = mask_t(1) << i;
+                int x = boxOf(r, c), cell = r * LEN + c;
+                if ((o.row[r] | o.col[c] | o.box[x]) & bit) {
+
+                    return false;
+                }
+                o.row[r] |= bit;
+                o.col[c] |= bit;
+                o.box[x] |= bit;
+
+                for (int k = 0; k < extraCount[cell]; ++k) {
+
+                    if ( o.extra[extraOf[cell][k]] & bit ) {
+
+                        return false;
+                    }
+                    o.extra[extraOf[cell][k]] |= bit;
+                }
+                if ( cageOf[cell] >= 0 ) {
+                    o.cageSum[cageOf[cell]] += i + 1;
+                    ++o.cageFilled[cageOf[cell]];
+                }
+            }
+        }
+
+        // givens that already overshoot a cage or fill it with the wrong sum
+        for (int k = 0; k < cages; ++k) {
+
+            if ( o.cageSum[k] > cageTarget[k] ||
+                 ( o.cageFilled[k] == cageSize[k] && o.cageSum[k] != cageTarget[k] ) ) {
+
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * fill the house table
+     * Helper Function
+     */
+    void initHouses()
+    {
+        int fill[LEN] = {0};
+        for (int i = 0; i < LEN; ++i) {
+            for (int j = 0; j < LEN; ++j) {
+
+                house[i][j] = i * LEN + j;
+                house[LEN + i][j] = j * LEN + i;
+
+                // row by row, so the cells of a box come out in reading order
+                int x = region[i * LEN + j];
+                house[2 * LEN + x][fill[x]++] = i * LEN + j;
+            }
+
+            house[3 * LEN][i] = i * LEN + i;
+            house[3 * LEN + 1][i] = i * LEN + LEN - 1 - i;
+        }
+    }
+
+    /**
+     * build the list of empty cells
+     * stored bottom right first so the top left cell sits at the end of the range
+     * Helper Function
+     * @param ec empty cells to fill
+     */
+    void initEmpty(emptyCells &ec)
+    {
+        ec.count = 0;
+        for (int r = LEN - 1; r >= 0; --r) {
+            for (int c = LEN - 1; c >= 0; --c) {
+
+                if (b[r][c] == NOTFILLED) {
+
+                    ec.pos[r * LEN + c] = ec.count;
+                    ec.cell[ec.count++] = r * LEN + c;
+                }
+            }
+        }
+    }
+
+    /**
+     * build the MASK engine state from the givens on the board
+     * Helper Function
+     * @param g grid to fill
+     * @return bool false if a given is repeated on one of the three constraints
+     */
+    bool initGrid(grid &g)
+    {
+        if ( !initOccupancy(g.o) ) {
+
+            return false;
+        }
+
+        initEmpty(g.ec);
+        std::memset(g.removed, 0, sizeof(g.removed));
+        g.placedTop = 0;
+        g.trailTop = 0;
+
+        return true;
+    }
+
+    /**
+     * swap two positions of the empty list
+     * Helper Function
+     * @param ec empty cells
+     * @param i position
+     * @param j position
+     */
+    void swapEmpty(emptyCells &ec, int i, int j)
+    {
+        int t = ec.cell[i];
+        ec.cell[i] = ec.cell[j];
+        ec.cell[j] = t;
+        ec.pos[ec.cell[i]] = i;
+        ec.pos[ec.cell[j]] = j;
+    }
+
+    /**
+     * candidates left for an empty cell
+     * Helper Function
+     * @param g grid
+     * @param cell r * LEN + c
+     * @return mask_t
+     */
+    mask_t candidatesOf(const grid &g, int cell)
+    {
+        const mask_t ALL = (mask_t(1) << LEN) - 1;
+        int r = cell / LEN, c = cell % LEN;
+
+        mask_t cand = ~(g.o.row[r] | g.o.col[c] | g.o.box[boxOf(r, c)] | g.removed[cell]) & ALL;
+
+        return hasVariant ? variantCandidates(g, cell, cand) : cand;
+    }
+
+    /**
+     * what the extra houses and the cage sum leave of the candidates of a cell
+     * Helper Function
+     * @param g grid
+     * @param cell r * LEN + c
+     * @param cand candidates the row, column and box leave
+     * @return mask_t
+     */
+    mask_t variantCandidates(const grid &g, int cell, mask_t cand)
+    {
+        for (int k = 0; k < extraCount[cell]; ++k) {
+            cand &= ~g.o.extra[extraOf[cell][k]];
+        }
+
+        return cageOf[cell] >= 0 && cand ? cand & cageFits(g, cageOf[cell], cand) : cand;
+    }
+
+    /**
+     * the candidates of an empty cell of cage k that still let the empty
+     * cells of the cage add up to what is left of its sum
+     * a symbol fits when the rest can be made of the other unused symbols,
+     * judged by the smallest and largest sums they can make, which is exact
+     * for the last empty cell of the cage
+     * Helper Function
+     * @param g grid
+     * @param k cage
+     * @param cand candidates of the cell, all of them unused in the cage
+     * @return mask_t
+     */
+    mask_t cageFits(const grid &g, int k, mask_t cand)
+    {
+        mask_t unused = ~g.o.extra[2 + k] & ALL;
+        int others = cageSize[k] - g.o.cageFilled[k] - 1;
+        int rest = cageTarget[k] - g.o.cageSum[k];
+
+        // low[j] is the sum of the j smallest unused symbols
+        int low[LEN + 1];
+        int n = 0;
+        low[0] = 0;
+        for (mask_t bits = unused; bits; bits &= bits - 1, ++n) {
+            low[n + 1] = low[n] + ctz(bits) + 1;
+        }
+
+        mask_t fits = 0;
+        for (mask_t bits = cand; bits; bits &= bits - 1) {
+
+            int i = ctz(bits), v = i + 1;
+            int below = popcount(unused & ((mask_t(1) << i) - 1)), above = n - 1 - below;
+
+            // smallest and largest sums of others unused symbols besides this one
+            int least = below < others ? low[others + 1] - v : low[others];
+            int most = above < others ? low[n] - low[n - others - 1] - v : low[n] - low[n - others];
+            if ( least <= rest - v && rest - v <= most ) {
+                fits |= bits & (~bits + 1);
+            }
+        }
+
+        return fits;
+    }
+
+    /**
+     * put SYM[i] on the cell and record it so it can be undone
+     * Helper Function
+     * @param g grid
+     * @param cell r * LEN + c, must be empty
+     * @param i symbol index
+     */
+    void place(grid &g, int cell, int i)
+    {
+        int r = cell / LEN, c = cell % LEN, x = boxOf(r, c);
+        mask_t bit = mask_t(1) << i;
+
+        b[r][c] = SYM[i];
+        g.o.row[r] |= bit;
+        g.o.col[c] |= bit;
+        g.o.box[x] |= bit;
+        for (int k = 0; k < extraCount[cell]; ++k) {
+            g.o.extra[extraOf[cell][k]] |= bit;
+        }
+        if ( cageOf[cell] >= 0 ) {
+            g.o.cageSum[cageOf[cell]] += i + 1;
+            ++g.o.cageFilled[cageOf[cell]];
+        }
+
+        swapEmpty(g.ec, g.ec.pos[cell], g.ec.count - 1);
+        --g.ec.count;
+        g.placed[g.placedTop] = cell;
+        g.placedSym[g.placedTop++] = i;
+    }
+
+    /**
+     * take SYM[i] off the cell and out of the occupancy, the empty list is left to the caller
+     * Helper Function
+     * @param g grid
+     * @param cell r * LEN + c
+     * @param i symbol index
+     */
+    void clear(grid &g, int cell, int i)
+    {
+        int r = cell / LEN, c = cell % LEN;
+        mask_t bit = mask_t(1) << i;
+
+        b[r][c] = NOTFILLED;
+        g.o.row[r] &= ~bit;
+        g.o.col[c] &= ~bit;
+        g.o.box[boxOf(r, c)] &= ~bit;
+        for (int k = 0; k < extraCount[cell]; ++k) {
+            g.o.extra[extraOf[cell][k]] &= ~bit;
+        }
+        if ( cageOf[cell] >= 0 ) {
+            g.o.cageSum[cageOf[cell]] -= i + 1;
+            --g.o.cageFilled[cageOf[cell]];
+        }
+    }
+
+    /**
+     * take candidates away from an empty cell and record it so it can be undone
+     * Helper Function
+     * @param g grid
+     * @param cell r * LEN + c
+     * @param bits candidates to take away
+     * @return bool true if the cell lost at least one candidate
+     */
+    bool eliminate(grid &g, int cell, mask_t bits)
+    {
+        if ( !(candidatesOf(g, cell) & bits) ) {
+
+            return false;
+        }
+
+        g.trailCell[g.trailTop] = cell;
+        g.trailMask[g.trailTop] = g.removed[cell];
+        ++g.trailTop;
+        g.removed[cell] |= bits;
+
+        return true;
+    }
+
+    /**
+     * pop moves and removals back to the marks
+     * the last placed cell always sits just past the empty range, so the
+     * empty list grows back without searching
+     * Helper Function
+     * @param g grid
+     * @param placedMark placedTop to return to
+     * @param trailMark trailTop to return to
+     */
+    void undo(grid &g, int placedMark, int trailMark)
+    {
+        while ( g.placedTop > placedMark ) {
+
+            --g.placedTop;
+            clear(g, g.placed[g.placedTop], g.placedSym[g.placedTop]);
+            ++g.ec.count;
+        }
+
+        while ( g.trailTop > trailMark ) {
+
+            --g.trailTop;
+            g.removed[g.trailCell[g.trailTop]] = g.trailMask[g.trailTop];
+        }
+    }
+
+    /**
+     * candidates and their count for every cell of the board, a row at a time
+     * the filled cells get whatever their row, column and box leave them
+     * Helper Function
+     * @param g grid
+     * @param cand candidates of each cell
+     * @param count popcount of each cand
+     */
+    void countCandidates(const grid &g, mask_t *cand, int *count)
+    {
+        mask_t box[LEN];
+        for (int band = 0; band < SUBLEN; ++band) {
+
+            // the box mask under every column of the band
+            for (int c = 0; c < LEN; ++c) {
+                box[c] = g.o.box[band * SUBLEN + c / SUBLEN];
+            }
+
+            for (int r = band * SUBLEN; r < (band + 1) * SUBLEN; ++r) {
+                rowCandidates(g.o.row[r], g.o.col, box, g.removed + r * LEN, ALL, LEN,
+                              cand + r * LEN, count + r * LEN);
+            }
+        }
+    }
+
+    /**
+     * move the next cell to fill to the end of the empty range
+     * Helper Function
+     * @param g grid, must have at least one empty cell
+     * @param h heuristic
+     * @return mask_t candidates of the chosen cell, 0 means a dead end
+     */
+    mask_t pickCell(grid &g, heuristic h)
+    {
+        const occupancy &o = g.o;
+        emptyCells &ec = g.ec;
+        int last = ec.count - 1;
+        int best = last;
+
+        if ( h == MRV ) {
+
+            // counting every cell only beats counting the empty ones with a vector kernel
+            bool vector = VECTOR && !hasVariant && candidates != candidatesScalar;
+            mask_t cand[VECTOR ? LEN * LEN : 1];
+            int count[VECTOR ? LEN * LEN : 1];
+            if ( vector ) {
+                countCandidates(g, cand, count);
+            }
+
+            int bestCount = LEN + 1;
+            int bestDegree = -1;
+            for (int i = last; i >= 0; --i) {
+
+                int r = ec.cell[i] / LEN, c = ec.cell[i] % LEN, x = boxOf(r, c);
+                int n = vector ? count[ec.cell[i]] : popcount(candidatesOf(g, ec.cell[i]));
+
+                // no candidates left, no point looking any further
+                if (n == 0) {
+                    best = i;
+                    break;
+                }
+
+                if (n > bestCount) {
+                    continue;
+                }
+
+                // empty cells sharing a constraint with this one
+                int degree = 3 * LEN - popcount(o.row[r]) -
+                             popcount(o.col[c]) - popcount(o.box[x]);
+                if (n < bestCount || degree > bestDegree) {
+                    best = i;
+                    bestCount = n;
+                    bestDegree = degree;
+                }
+            }
+
+            swapEmpty(ec, best, last);
+        }
+
+        return candidatesOf(g, ec.cell[last]);
+    }
+
+    /**
+     * naked singles : a cell with one candidate left takes it
+     * Helper Function
+     * @param g grid
+     * @param changed set when a symbol is placed
+     * @return bool false when a cell has no candidates left
+     */
+    bool nakedSingles(grid &g, bool &changed)
+    {
+        // walk down so a placement only swaps in cells already looked at
+        for (int i = g.ec.count - 1; i >= 0; --i) {
+
+            int cell = g.ec.cell[i];
+            mask_t cand = candidatesOf(g, cell);
+            if ( cand == 0 ) {
+
+                return false;
+            }
+
+            if ( (cand & (cand - 1)) == 0 ) {
+
+                place(g, cell, ctz(cand));
+                ++m.nakedSingles;
+                changed = true;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * hidden singles : a symbol with one place left in a house goes there
+     * Helper Function
+     * @param g grid
+     * @param changed set when a symbol is placed
+     * @return bool false when a symbol has no place left in a house
+     */
+    bool hiddenSingles(grid &g, bool &changed)
+    {
+        for (int h = 0; h < houses; ++h) {
+
+            // once has the symbols seen in at least one cell, twice in two or more
+            mask_t once = 0, twice = 0;
+            mask_t filled = h < LEN ? g.o.row[h] :
+                            h < 2 * LEN ? g.o.col[h - LEN] :
+                            h < 3 * LEN ? g.o.box[h - 2 * LEN] :
+                            g.o.extra[h - 3 * LEN];
+            for (int j = 0; j < LEN; ++j) {
+
+                int cell = house[h][j];
+                if ( b[cell / LEN][cell % LEN] == NOTFILLED ) {
+                    mask_t cand = candidatesOf(g, cell);
+                    twice |= once & cand;
+                    once |= cand;
+                }
+            }
+
+            if ( (once | filled) != ALL ) {
+
+                return false;
+            }
+
+            mask_t single = once & ~twice & ~filled;
+            while ( single ) {
+
+                int i = ctz(single);
+                single &= single - 1;
+
+                int j = 0;
+                while ( j < LEN && ( b[house[h][j] / LEN][house[h][j] % LEN] != NOTFILLED ||
+                                     !(candidatesOf(g, house[h][j]) & (mask_t(1) << i)) ) ) {
+                    ++j;
+                }
+
+                // an earlier placement in this house took the only place
+                if ( j == LEN ) {
+
+                    return false;
+                }
+
+                place(g, house[h][j], i);
+                ++m.hiddenSingles;
+                changed = true;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * naked pairs : two cells of a house with the same two candidates
+     * take those two symbols away from the rest of the house
+     * hidden pairs : two symbols with the same two places in a house
+     * take every other candidate away from those two cells
+     * Helper Function
+     * @param g grid
+     * @param changed set when a candidate is taken away
+     */
+    void pairs(grid &g, bool &changed)
+    {
+        for (int h = 0; h < houses; ++h) {
+
+            mask_t cand[LEN];
+            mask_t where[LEN] = {0};
+            for (int j = 0; j < LEN; ++j) {
+
+                int cell = house[h][j];
+                cand[j] = b[cell / LEN][cell % LEN] == NOTFILLED ? candidatesOf(g, cell) : 0;
+                for (mask_t bits = cand[j]; bits; bits &= bits - 1) {
+                    where[ctz(bits)] |= mask_t(1) << j;
+                }
+            }
+
+            for (int j = 0; j < LEN; ++j) {
+
+                if ( popcount(cand[j]) != 2 ) {
+                    continue;
+                }
+
+                for (int k = j + 1; k < LEN; ++k) {
+
+                    if ( cand[k] != cand[j] ) {
+                        continue;
+                    }
+
+                    bool hit = false;
+                    for (int l = 0; l < LEN; ++l) {
+
+                        if ( l != j && l != k && cand[l] && eliminate(g, house[h][l], cand[j]) ) {
+                            hit = true;
+                        }
+                    }
+
+                    if ( hit ) {
+                        ++m.nakedPairs;
+                        changed = true;
+                    }
+                }
+            }
+
+            for (int i = 0; i < LEN; ++i) {
+
+                if ( popcount(where[i]) != 2 ) {
+                    continue;
+                }
+
+                for (int k = i + 1; k < LEN; ++k) {
+
+                    if ( where[k] != where[i] ) {
+                        continue;
+                    }
+
+                    mask_t keep = (mask_t(1) << i) | (mask_t(1) << k);
+                    bool hit = false;
+                    for (mask_t bits = where[i]; bits; bits &= bits - 1) {
+
+                        if ( eliminate(g, house[h][ctz(bits)], ~keep) ) {
+                            hit = true;
+                        }
+                    }
+
+                    if ( hit ) {
+                        ++m.hiddenPairs;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * is the cell on house h
+     * Helper Function
+     * @param cell r * LEN + c
+     * @param h house
+     * @return bool
+     */
+    bool inHouse(int cell, int h)
+    {
+        int r = cell / LEN, c = cell % LEN;
+
+        return h < LEN ? r == h :
+               h < 2 * LEN ? c == h - LEN :
+               boxOf(r, c) == h - 2 * LEN;
+    }
+
+    /**
+     * take each symbol of bits away from the empty cells of house target
+     * that are not on house keep, one rule hit per symbol that went anywhere
+     * Helper Function
+     * @param g grid
+     * @param target house losing the symbols
+     * @param keep house whose cells are left alone
+     * @param bits symbols to take away
+     * @return int symbols that took a candidate away
+     */
+    int sweep(grid &g, int target, int keep, mask_t bits)
+    {
+        int hits = 0;
+        for (; bits; bits &= bits - 1) {
+
+            mask_t bit = bits & (~bits + 1);
+            bool hit = false;
+            for (int j = 0; j < LEN; ++j) {
+
+                int cell = house[target][j];
+                if ( b[cell / LEN][cell % LEN] == NOTFILLED && !inHouse(cell, keep) &&
+                     eliminate(g, cell, bit) ) {
+                    hit = true;
+                }
+            }
+
+            if ( hit ) {
+                ++hits;
+            }
+        }
+
+        return hits;
+    }
+
+    /**
+     * pointing : a symbol confined to one row or column of a sub board
+     * is taken away from the rest of that row or column
+     * claiming : a symbol confined to one sub board within a row or column
+     * is taken away from the rest of that sub board
+     * both come out of the segments where a line crosses a sub board,
+     * a symbol in one segment and in none of the others on the same
+     * sub board, or on the same line, is confined to it
+     * Helper Function
+     * @param g grid
+     * @param changed set when a candidate is taken away
+     */
+    void lines(grid &g, bool &changed)
+    {
+        // rowSeg[r][k] has the candidates of row r inside sub board column k,
+        // colSeg[c][k] those of column c inside sub board row k
+        mask_t rowSeg[LEN][SUBLEN] = {};
+        mask_t colSeg[LEN][SUBLEN] = {};
+        for (int i = 0; i < g.ec.count; ++i) {
+
+            int cell = g.ec.cell[i];
+            int r = cell / LEN, c = cell % LEN;
+            mask_t cand = candidatesOf(g, cell);
+            rowSeg[r][c / SUBLEN] |= cand;
+            colSeg[c][r / SUBLEN] |= cand;
+        }
+
+        int hits = 0;
+        for (int line = 0; line < LEN; ++line) {
+
+            int top = line - line % SUBLEN;
+            for (int k = 0; k < SUBLEN; ++k) {
+
+                mask_t rowBox = 0, rowLine = 0, colBox = 0, colLine = 0;
+                for (int j = 0; j < SUBLEN; ++j) {
+
+                    if ( top + j != line ) {
+                        rowBox |= rowSeg[top + j][k];
+                        colBox |= colSeg[top + j][k];
+                    }
+                    if ( j != k ) {
+                        rowLine |= rowSeg[line][j];
+                        colLine |= colSeg[line][j];
+                    }
+                }
+
+                int rowsBox = 2 * LEN + (line / SUBLEN) * SUBLEN + k;
+                int colsBox = 2 * LEN + k * SUBLEN + line / SUBLEN;
+
+                hits = sweep(g, line, rowsBox, rowSeg[line][k] & ~rowBox);
+                m.pointing += hits;
+                changed = changed || hits > 0;
+
+                hits = sweep(g, LEN + line, colsBox, colSeg[line][k] & ~colBox);
+                m.pointing += hits;
+                changed = changed || hits > 0;
+
+                hits = sweep(g, rowsBox, line, rowSeg[line][k] & ~rowLine);
+                m.claiming += hits;
+                changed = changed || hits > 0;
+
+                hits = sweep(g, colsBox, LEN + line, colSeg[line][k] & ~colLine);
+                m.claiming += hits;
+                changed = changed || hits > 0;
+            }
+        }
+    }
+
+    /**
+     * run the propagation rules until none of them make progress
+     * the cheap singles run to a standstill before pairs and pointing get a turn
+     *
+     * @param g grid
+     * @param singlesOnly stop once the singles are done
+     * @return bool false when the board can not be completed
+     */
+    bool propagate(grid &g, bool singlesOnly = false)
+    {
+        bool changed = true;
+        while ( changed && g.ec.count > 0 ) {
+
+            changed = false;
+            if ( !nakedSingles(g, changed) ) {
+                return false;
+            }
+            if ( changed ) {
+                continue;
+            }
+
+            if ( !hiddenSingles(g, changed) ) {
+                return false;
+            }
+            if ( changed || singlesOnly ) {
+                continue;
+            }
+
+            pairs(g, changed);
+            if ( changed ) {
+                continue;
+            }
+
+            // the segments of lines() are cut along the usual boxes
+            if ( !jigsaw ) {
+                lines(g, changed);
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * the actual work comes together here
+     *
+     * @return
+     */
+    bool work()
+    {
+        int r = 0, c = 0;
+        ++m.iterations;
+        enter();
+
+        // at this point the puzzle is solved
+        if ( !isNotFilled(r, c) ) {
+
+            return true;
+        }
+
+        // iterate through the allowed symbols
+    //    for ( auto it = sym.begin(); it != sym.end(); ++it ) {
+        for ( int i = 0; i < LEN; ++i ) {
+
+            // v is a possible candidate during traversal
+    //        char v = *it;
+            char v = SYM[i];
+            if ( isLegal(r, c, v) )
+            {
+                b[r][c] = v;
+
+                // if filled by the next move and passed the three
+                // constraints then v is the correct choice
+                if ( work() ) {
+
+                    return true;
+
+                }
+
+                // at this point v failed to meet the constraints and is set to NOTFILLED
+                // this propagates the recursion to traverse back one step
+                // and try from the address of r and c on the recursion stack
+                b[r][c] = NOTFILLED;
+                ++m.backtracked;
+                --m.stackHeight;
+
+            }
+        }
+        return false;
+    }
+
+    /**
+     * a node is entered, one level deeper than its parent
+     * Helper Function
+     */
+    void enter()
+    {
+        if ( ++m.stackHeight > m.maxStackHeight ) {
+            m.maxStackHeight = m.stackHeight;
+        }
+    }
+
+    /**
+     * note a complete board
+     * Helper Function
+     * @param limit solutions to look for, 0 counts them all
+     * @return bool true once the limit is reached
+     */
+    bool solution(long long limit)
+    {
+        if ( found++ == 0 ) {
+            first.assign(&b[0][0], LEN * LEN);
+        }
+
+        long long total = sharedFound ? ++*sharedFound : found;
+        if ( limit != 0 && total >= limit ) {
+
+            if ( stop ) {
+                *stop = true;
+            }
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * same search as work() but the legality check is a single AND
+     * against the occupancy bit sets instead of rescanning the board
+     * and the next cell comes off the empty cell list instead of a board scan
+     * with propagation on, the rules run at every node before branching
+     * and everything they placed or took away is undone on the way back
+     *
+     * @param g grid, updated as symbols are placed and removed
+     * @param h heuristic picking the next cell
+     * @param rules run the propagation rules at every node
+     * @param limit solutions to look for, 0 counts them all
+     * @return bool true once the search should stop
+     */
+    bool workMask(grid &g, heuristic h, bool rules, long long limit)
+    {
+        // another worker of the parallel search is done
+        if ( stop && stop->load(std::memory_order_relaxed) ) {
+
+            return true;
+        }
+
+        ++m.iterations;
+        enter();
+
+        int placedMark = g.placedTop;
+        int trailMark = g.trailTop;
+        if ( rules && !propagate(g) ) {
+
+            undo(g, placedMark, trailMark);
+            return false;
+        }
+
+        // at this point the puzzle is solved
+        if ( g.ec.count == 0 ) {
+
+            if ( solution(limit) ) {
+
+                return true;
+            }
+
+            // keep counting
+            undo(g, placedMark, trailMark);
+            return false;
+        }
+
+        mask_t cand = pickCell(g, h);
+        int cell = g.ec.cell[g.ec.count - 1];
+
+        // iterate through the allowed symbols in the same order as work()
+        for ( int i = 0; i < LEN; ++i ) {
+
+            if ( cand & (mask_t(1) << i) )
+            {
+                place(g, cell, i);
+
+                if ( workMask(g, h, rules, limit) ) {
+
+                    return true;
+
+                }
+
+                // undo the move on the board as well as the three constraints
+                undo(g, g.placedTop - 1, g.trailTop);
+                ++m.backtracked;
+                --m.stackHeight;
+
+            }
+        }
+
+        // take back what the rules did at this node
+        undo(g, placedMark, trailMark);
+        return false;
+    }
+
+    /**
+     * set up the ITER engine for a fresh search of the board
+     *
+     * @param opt whether to run the propagation rules
+     * @return bool false if a given is repeated on one of the three constraints
+     */
+    bool beginIter(const options &opt)
+    {
+        grid &g = maskState();
+        if ( !initGrid(g) ) {
+
+            return false;
+        }
+
+        g.top = 0;
+        g.enterNext = true;
+        m.propagation = opt.rules;
+        return true;
+    }
+
+    /**
+     * the MASK search without recursion, every level lives on the
+     * preallocated stack of the grid so nothing is allocated on the way
+     * and a search can stop after budget nodes and carry on later
+     * visits the nodes in the same order as workMask() and keeps the same metrics
+     *
+     * @param opt heuristic, whether to run the propagation rules and
+     *            how many solutions to look for
+     * @param budget nodes to visit before pausing, 0 runs to the end
+     * @return bool true once the search is over, false when it paused
+     */
+    bool resumeIter(const options &opt, long long budget)
+    {
+        grid &g = *state;
+        long long spent = 0;
+
+        while ( true ) {
+
+            if ( g.enterNext ) {
+
+                // another worker of the parallel search is done
+                if ( stop && stop->load(std::memory_order_relaxed) ) {
+
+                    return true;
+                }
+
+                if ( budget != 0 && spent == budget ) {
+
+                    return false;
+                }
+
+                ++spent;
+                ++m.iterations;
+                enter();
+                g.enterNext = false;
+
+                int placedMark = g.placedTop;
+                int trailMark = g.trailTop;
+                bool dead = opt.rules && !propagate(g, opt.singlesOnly);
+
+                // at this point the puzzle is solved
+                if ( !dead && g.ec.count == 0 ) {
+
+                    if ( solution(opt.limit) ) {
+
+                        return true;
+                    }
+
+                    // keep counting
+                    dead = true;
+                }
+
+                if ( !dead ) {
+
+                    mask_t cand = pickCell(g, opt.h);
+                    frame &f = g.stack[g.top++];
+                    f.cell = g.ec.cell[g.ec.count - 1];
+                    f.cand = cand;
+                    f.placedMark = placedMark;
+                    f.trailMark = trailMark;
+                    f.branchPlaced = g.placedTop;
+                    f.branchTrail = g.trailTop;
+                    continue;
+                }
+
+                undo(g, placedMark, trailMark);
+                if ( g.top == 0 ) {
+
+                    return true;
+                }
+                ++m.backtracked;
+                --m.stackHeight;
+            }
+
+            // back at the deepest level, take back the last branch move
+            frame &f = g.stack[g.top - 1];
+            undo(g, f.branchPlaced, f.branchTrail);
+
+            if ( f.cand == 0 ) {
+
+                // every candidate failed, take back what the rules did at this level
+                undo(g, f.placedMark, f.trailMark);
+                if ( --g.top == 0 ) {
+
+                    return true;
+                }
+                ++m.backtracked;
+                --m.stackHeight;
+                continue;
+            }
+
+            int i = ctz(f.cand);
+            f.cand &= f.cand - 1;
+            place(g, f.cell, i);
+            g.enterNext = true;
+        }
+    }
+
+    /**
+     * link up the full exact cover matrix, every candidate of every cell
+     * Helper Function
+     * @param d matrix to build
+     */
+    void initDlx(dlx &d)
+    {
+        for (int i = 0; i <= dlx::COLS; ++i) {
+
+            d.left[i] = i == 0 ? dlx::COLS : i - 1;
+            d.right[i] = i == dlx::COLS ? 0 : i + 1;
+            d.up[i] = d.down[i] = d.col[i] = i;
+            d.size[i] = 0;
+        }
+
+        for (int k = 0; k < dlx::ROWS; ++k) {
+
+            int cell = k / LEN, i = k % LEN;
+            int r = cell / LEN, c = cell % LEN;
+            int cols[4] = {
+                1 + cell,
+                1 + LEN * LEN + r * LEN + i,
+                1 + 2 * LEN * LEN + c * LEN + i,
+                1 + 3 * LEN * LEN + boxOf(r, c) * LEN + i
+            };
+
+            int first = 1 + dlx::COLS + 4 * k;
+            for (int j = 0; j < 4; ++j) {
+
+                int n = first + j;
+                d.left[n] = first + (j + 3) % 4;
+                d.right[n] = first + (j + 1) % 4;
+
+                // append to the bottom of the column
+                d.col[n] = cols[j];
+                d.up[n] = d.up[cols[j]];
+                d.down[n] = cols[j];
+                d.down[d.up[cols[j]]] = n;
+                d.up[cols[j]] = n;
+                ++d.size[cols[j]];
+            }
+        }
+
+        d.depth = 0;
+        d.found = 0;
+    }
+
+    /**
+     * take column c out of the header list along with every row that hits it
+     * Helper Function
+     * @param d matrix
+     * @param c column header
+     */
+    void cover(dlx &d, int c)
+    {
+        d.right[d.left[c]] = d.right[c];
+        d.left[d.right[c]] = d.left[c];
+
+        for (int i = d.down[c]; i != c; i = d.down[i]) {
+            for (int j = d.right[i]; j != i; j = d.right[j]) {
+
+                d.down[d.up[j]] = d.down[j];
+                d.up[d.down[j]] = d.up[j];
+                --d.size[d.col[j]];
+            }
+        }
+    }
+
+    /**
+     * put column c back, exactly reversing cover()
+     * Helper Function
+     * @param d matrix
+     * @param c column header
+     */
+    void uncover(dlx &d, int c)
+    {
+        for (int i = d.up[c]; i != c; i = d.up[i]) {
+            for (int j = d.left[i]; j != i; j = d.left[j]) {
+
+                ++d.size[d.col[j]];
+                d.down[d.up[j]] = j;
+                d.up[d.down[j]] = j;
+            }
+        }
+
+        d.right[d.left[c]] = c;
+        d.left[d.right[c]] = c;
+    }
+
+    /**
+     * cover the four columns of the candidate rows of the givens
+     * Helper Function
+     * @param d matrix built by initDlx()
+     * @return bool false if two givens want the same column
+     */
+    bool coverGivens(dlx &d)
+    {
+        for (int r = 0; r < LEN; ++r) {
+            for (int c = 0; c < LEN; ++c) {
+
+                int i = symIndex(b[r][c]);
+                if (i < 0) {
+                    continue;
+                }
+
+                int first = 1 + dlx::COLS + 4 * ((r * LEN + c) * LEN + i);
+                for (int j = 0; j < 4; ++j) {
+
+                    // a covered column is no longer in the header list
+                    int cl = d.col[first + j];
+                    if (d.right[d.left[cl]] != cl) {
+
+                        return false;
+                    }
+                }
+
+                for (int j = 0; j < 4; ++j) {
+                    cover(d, d.col[first + j]);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Algorithm X on the dancing links, always branching on the column
+     * with the fewest rows left; stops once limit covers have been found
+     * the first cover found is written onto the board
+     *
+     * @param d matrix with the givens covered
+     * @param limit number of solutions to look for, 0 counts them all
+     */
+    void workDlx(dlx &d, long long limit)
+    {
+        ++m.iterations;
+        enter();
+
+        // every column is covered, the path is a solution
+        if ( d.right[0] == 0 ) {
+
+            if ( d.found++ == 0 ) {
+                for (int k = 0; k < d.depth; ++k) {
+
+                    int cell = d.path[k] / LEN;
+                    b[cell / LEN][cell % LEN] = SYM[d.path[k] % LEN];
+                }
+            }
+
+            return;
+        }
+
+        int c = d.right[0];
+        for (int j = d.right[c]; j != 0; j = d.right[j]) {
+
+            if ( d.size[j] < d.size[c] ) {
+                c = j;
+            }
+        }
+
+        // a constraint nobody can satisfy any more
+        if ( d.size[c] == 0 ) {
+
+            return;
+        }
+
+        cover(d, c);
+        for (int i = d.down[c]; i != c && ( limit == 0 || d.found < limit ); i = d.down[i]) {
+
+            d.path[d.depth++] = (i - 1 - dlx::COLS) / 4;
+            for (int j = d.right[i]; j != i; j = d.right[j]) {
+                cover(d, d.col[j]);
+            }
+
+            workDlx(d, limit);
+
+            for (int j = d.left[i]; j != i; j = d.left[j]) {
+                uncover(d, d.col[j]);
+            }
+            --d.depth;
+
+            if ( limit == 0 || d.found < limit ) {
+                ++m.backtracked;
+                --m.stackHeight;
+            }
+        }
+        uncover(d, c);
+    }
+
+    /**
+     * count the solutions of the board with Dancing Links, up to limit
+     * the board gets the first solution found
+     *
+     * @param limit stop counting here, 0 counts them all
+     * @return long long number of solutions found, at most limit
+     */
+    long long countDlx(long long limit)
+    {
+        // the matrix is too big for the stack on the larger boards
+        // and is kept for the next puzzle
+        if ( !matrix ) {
+            matrix.reset(new dlx);
+        }
+        dlx &d = *matrix;
+        initDlx(d);
+        if ( !coverGivens(d) ) {
+
+            return 0;
+        }
+
+        workDlx(d, limit);
+        return d.found;
+    }
+
+public:
+
+    /**
+     * the MASK engine state, made on first use
+     * the grid is too big for the stack on the larger boards
+     * and is kept for the next puzzle
+     * @return grid
+     */
+    grid &maskState()
+    {
+        if ( !state ) {
+            state.reset(new grid);
+        }
+
+        return *state;
+    }
+
+    /**
+     * solve the board with the chosen engine
+     * found gets the number of solutions seen, up to the limit,
+     * and the board is left holding the first of them
+     *
+     * @param opt engine, heuristic used by the MASK engine,
+     *            whether to run the propagation rules, MASK engine only,
+     *            and how many solutions to look for
+     * @return bool
+     */
+    bool solve(const options &opt)
+    {
+        engine e = opt.e;
+        heuristic h = opt.h;
+        bool rules = opt.rules;
+
+        if ( e == MASK ) {
+
+            grid &g = maskState();
+            if ( !initGrid(g) ) {
+
+                return false;
+            }
+
+            m.propagation = rules;
+            workMask(g, h, rules, opt.limit);
+            if ( found > 0 ) {
+                std::memcpy(&b[0][0], first.data(), LEN * LEN);
+            }
+
+            return found > 0;
+        }
+
+        if ( e == DLX ) {
+
+            found = countDlx(opt.limit);
+            return found > 0;
+        }
+
+        if ( e == ITER ) {
+
+            if ( !beginIter(opt) ) {
+
+                return false;
+            }
+
+            while ( !resumeIter(opt, opt.slice) ) {
+                ++pauses;
+            }
+            if ( found > 0 ) {
+                std::memcpy(&b[0][0], first.data(), LEN * LEN);
+            }
+
+            return found > 0;
+        }
+
+        found = work() ? 1 : 0;
+        return found > 0;
+    }
+
+    /**
+     * take the board one level down the search tree for the parallel search
+     * runs the rules when asked, picks a cell like the MASK engine does
+     * and hands back the board with each of its candidates filled in
+     *
+     * @param opt heuristic and whether to run the propagation rules
+     * @param children boards of the next level, one line each
+     * @return bool true once the search should stop
+     */
+    bool split(const options &opt, std::vector<std::string> &children)
+    {
+        ++m.iterations;
+        m.propagation = opt.rules;
+
+        grid &g = maskState();
+        if ( !initGrid(g) || ( opt.rules && !propagate(g) ) ) {
+
+            return false;
+        }
+
+        if ( g.ec.count == 0 ) {
+
+            return solution(opt.limit);
+        }
+
+        mask_t cand = pickCell(g, opt.h);
+        int cell = g.ec.cell[g.ec.count - 1];
+        char &v = b[cell / LEN][cell % LEN];
+        for ( int i = 0; i < LEN; ++i ) {
+
+            if ( cand & (mask_t(1) << i) ) {
+
+                v = SYM[i];
+                children.push_back(line());
+            }
+        }
+        v = NOTFILLED;
+
+        return false;
+    }
+
+    /**
+     * run the ITER engine but give up after budget nodes, for the generator
+     * which would rather throw a board away than wait on it
+     *
+     * @param opt heuristic, whether to run the propagation rules and
+     *            how many solutions to look for
+     * @param budget nodes to visit before giving up, 0 runs to the end
+     * @return bool false if it gave up before the search was over
+     */
+    bool solveWithin(const options &opt, long long budget)
+    {
+        if ( beginIter(opt) && !resumeIter(opt, budget) ) {
+
+            return false;
+        }
+
+        if ( found > 0 ) {
+            std::memcpy(&b[0][0], first.data(), LEN * LEN);
+        }
+
+        return true;
+    }
+
+    /**
+     * set up the grid of the ITER engine once for digging the clues out of
+     * the board, digOut() then takes them off one at a time on this one state
+     * instead of loading and rebuilding the board for every try
+     *
+     * @return bool false if a symbol is repeated on one of the three constraints
+     */
+    bool beginDig()
+    {
+        return initGrid(maskState());
+    }
+
+    /**
+     * take the clue off the cell if the board keeps a single solution without it
+     * the uniqueness check of the generator: when the board with the clue
+     * has a single solution, the board without it has another one only if
+     * that one puts something else there, so one search with the clue's symbol
+     * ruled out of the cell does the work of counting to two
+     * the clue is lifted off the grid as it stands and everything the search
+     * did is undone, a clue that stays goes back on as one that is not recorded
+     *
+     * @param opt heuristic and whether to run the propagation rules
+     * @param cell r * LEN + c, a clue on the board
+     * @param budget nodes to visit before giving up and keeping the clue, 0 runs to the end
+     * @return bool true if the clue is gone
+     */
+    bool digOut(const options &opt, int cell, long long budget)
+    {
+        grid &g = *state;
+        int i = symIndex(b[cell / LEN][cell % LEN]);
+        mask_t bit = mask_t(1) << i;
+
+        clear(g, cell, i);
+        g.ec.pos[cell] = g.ec.count;
+        g.ec.cell[g.ec.count++] = cell;
+        g.removed[cell] |= bit;
+
+        g.top = 0;
+        g.enterNext = true;
+        m.propagation = opt.rules;
+        found = 0;
+        bool gone = resumeIter(opt, budget) && found == 0;
+
+        undo(g, 0, 0);
+        g.removed[cell] &= ~bit;
+        if ( !gone ) {
+
+            place(g, cell, i);
+            g.placedTop = 0;
+        }
+
+        return gone;
+    }
+
+    /**
+     * Print the board
+     */
+    void print()
+    {
+        std::cout << std::endl;
+
+        for (int r = 0; r < LEN; ++r)
+        {
+            for (int c = 0; c < LEN; ++c) {
+
+                std::cout << b[r][c];
+            }
+
+            std::cout << std::endl;
+        }
+
+        printMetrics(m);
+    }
+
+    /**
+     * the board as one line, row after row
+     * @return std::string
+     */
+    std::string line() const
+    {
+        return std::string(&b[0][0], LEN * LEN);
+    }
+
+    /**
+     * the board in place, row after row, LEN * LEN characters and no terminator
+     * @return const char *
+     */
+    const char *cells() const
+    {
+        return &b[0][0];
+    }
+};
+
+template <int SUBLEN> constexpr int Sudoku<SUBLEN>::LEN;
+template <int SUBLEN> constexpr typename Sudoku<SUBLEN>::mask_t Sudoku<SUBLEN>::ALL;
+template <int SUBLEN> constexpr const char *Sudoku<SUBLEN>::SYM;
+template <int SUBLEN> constexpr bool Sudoku<SUBLEN>::VECTOR;
+
+/**
+ * the largest board, 36x36
+ */
+const int MAXLEN = 36;
+
+/**
+ * what the reader came across next
+ * PUZZLE a whole puzzle, MALFORMED something that should have been one
+ * but is not, END the end of the input
+ */
+enum readStatus { PUZZLE, MALFORMED, END };
+
+/**
+ * is v a symbol of the board with len symbols, the same ones as Sudoku<>::SYM
+ * @param v character
+ * @param len symbols on the board
+ * @return bool
+ */
+bool isSymbol(char v, int len)
+{
+    if ( len <= 9 ) {
+
+        return v >= '1' && v < '1' + len;
+    }
+
+    return ( v >= '0' && v <= '9' ) || ( v >= 'A' && v < 'A' + len - 10 );
+}
+
+/**
+ * the input of the solver, mapped into memory and cut into puzzles where it lies
+ * a puzzle is either one line with all of its cells or a grid with one row
+ * per line, blanks are '.' or NOTFILLED, or '0' on the boards up to 9x9
+ * empty lines and lines starting with '#' sit between puzzles, anything
+ * after a space or tab on a line is ignored
+ * a line of 16 cells starts a 16x16 grid when it and the 15 lines after it
+ * are all bare rows of 16 cells, nothing after them, otherwise it is a whole
+ * 4x4 puzzle, so one-line 4x4 puzzles can follow each other
+ * stdin can not be mapped, it is read into one buffer up front
+ */
+class puzzleReader {
+
+public:
+
+    /**
+     * map the file
+     * @param name file name, "-" for stdin
+     */
+    explicit puzzleReader(const std::string &name) : file(name) {
+
+        if ( name == "-" ) {
+
+            buffer.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+            data = buffer.data();
+            size = buffer.size();
+            opened = true;
+            return;
+        }
+
+        struct stat st;
+        fd = open(name.c_str(), O_RDONLY);
+        if ( fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ) {
+
+            return;
+        }
+
+        opened = true;
+        size = st.st_size;
+        if ( size == 0 ) {
+
+            return;
+        }
+
+        void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if ( p == MAP_FAILED ) {
+
+            opened = false;
+            return;
+        }
+        madvise(p, size, MADV_SEQUENTIAL);
+        data = static_cast<const char *>(p);
+        mapped = true;
+    }
+
+    ~puzzleReader() {
+
+        if ( mapped ) {
+            munmap(const_cast<char *>(data), size);
+        }
+        if ( fd >= 0 ) {
+            close(fd);
+        }
+    }
+
+    puzzleReader(const puzzleReader &) = delete;
+    puzzleReader &operator=(const puzzleReader &) = delete;
+
+    /**
+     * @return bool false if the input could not be opened
+     */
+    bool isOpen() const {
+
+        return opened;
+    }
+
+    /**
+     * @return what was wrong with the last MALFORMED puzzle, with its line number
+     */
+    const std::string &error() const {
+
+        return err;
+    }
+
+    /**
+     * read the next puzzle, every cell is checked before it is copied so
+     * nothing bigger than MAXLEN x MAXLEN ever reaches cells
+     * after a malformed grid the rest of its rows are skipped, up to the
+     * next empty line, so the puzzles after it still line up
+     * the variant lines right after the puzzle, if any, go into v
+     *
+     * @param cells the puzzle, row after row, blanks as NOTFILLED
+     * @param len board length
+     * @param first line the puzzle starts on
+     * @param v the variant of the puzzle, nullptr to check and drop it
+     * @return readStatus
+     */
+    readStatus next(char *cells, int &len, int &first, variant *v = nullptr) {
+
+        const char *begin, *end;
+        size_t start;
+        do {
+
+            start = at;
+            if ( !nextLine(begin, end) ) {
+
+                return END;
+            }
+        } while ( begin == end || *begin == '#' );
+
+        first = lineNo;
+        int n = end - begin;
+        if ( n == 4 || n == 9 || n == 25 || n == MAXLEN || ( n == 16 && gridFollows(start, 16) ) ) {
+
+            len = n;
+            for ( int r = 0; r < len; ++r ) {
+
+                if ( r > 0 && ( !nextLine(begin, end) || begin == end ) ) {
+
+                    return malformed(lineNo, "the grid ends after " + std::to_string(r) +
+                                     " rows, expected " + std::to_string(len));
+                }
+
+                if ( end - begin != len ) {
+
+                    malformed(lineNo, "the row has " + std::to_string(end - begin) +
+                              " cells, expected " + std::to_string(len));
+                    skipRows(len - r - 1);
+                    return MALFORMED;
+                }
+
+                if ( !copyCells(begin, len, len, cells + r * len) ) {
+
+                    skipRows(len - r - 1);
+                    return MALFORMED;
+                }
+            }
+
+            return readVariant(len, v);
+        }
+
+        for ( len = 2; len <= MAXLEN && len * len < n; ++len ) {
+        }
+        if ( len * len != n || ( len != 4 && len != 9 && len != 16 && len != 25 && len != MAXLEN ) ) {
+
+            return malformed(lineNo, std::to_string(n) + " cells is neither a row nor a whole puzzle");
+        }
+
+        return copyCells(begin, n, len, cells) ? readVariant(len, v) : MALFORMED;
+    }
+
+private:
+
+    std::string file;
+    int fd = -1;
+    bool opened = false;
+    bool mapped = false;
+    const char *data = nullptr;
+    size_t size = 0;
+    size_t at = 0;
+    int lineNo = 0;
+    std::string buffer;
+    std::string err;
+
+    /**
+     * the next line, without the line end and whatever follows a space or tab
+     * Helper Function
+     * @param begin first character
+     * @param end one past the last character
+     * @param whole keep what follows a space or tab
+     * @return bool false at the end of the input
+     */
+    bool nextLine(const char *&begin, const char *&end, bool whole = false) {
+
+        if ( at >= size ) {
+
+            return false;
+        }
+
+        begin = data + at;
+        const char *nl = static_cast<const char *>(std::memchr(begin, '\n', size - at));
+        const char *stop = nl ? nl : data + size;
+        at = stop - data + 1;
+        ++lineNo;
+
+        end = begin;
+        while ( end < stop && *end != '\r' && ( whole || ( *end != ' ' && *end != '\t' ) ) ) {
+            ++end;
+        }
+
+        return true;
+    }
+
+    /**
+     * is the text from begin to end exactly word
+     * Helper Function
+     * @param begin first character
+     * @param end one past the last character
+     * @param word word
+     * @return bool
+     */
+    static bool isWord(const char *begin, const char *end, const char *word) {
+
+        return (size_t) (end - begin) == std::strlen(word) && std::memcmp(begin, word, end - begin) == 0;
+    }
+
+    /**
+     * the variant lines after a puzzle, as many as there are
+     *   diagonal
+     *   jigsaw, then LEN rows with a label for the region of every cell
+     *   cage <sum> r<row>c<column> ..., rows and columns counting from 1
+     * Helper Function
+     * @param len board length
+     * @param v the variant read, nullptr to check and drop it
+     * @return readStatus
+     */
+    readStatus readVariant(int len, variant *v) {
+
+        variant dropped;
+        if ( v == nullptr ) {
+            v = &dropped;
+        }
+        *v = variant();
+
+        std::vector<int> owner;
+        while ( true ) {
+
+            size_t atWas = at;
+            int lineWas = lineNo;
+            const char *begin, *end;
+            if ( !nextLine(begin, end, true) ) {
+
+                return PUZZLE;
+            }
+
+            const char *space = std::find(begin, end, ' ');
+            if ( isWord(begin, space, "diagonal") ) {
+
+                v->diagonal = true;
+            } else if ( isWord(begin, space, "jigsaw") ) {
+
+                // labels are numbered in the order they turn up
+                int id[256];
+                int cells[MAXLEN] = {0};
+                int regions = 0;
+                std::fill(id, id + 256, -1);
+                v->region.assign(len * len, 0);
+                for ( int r = 0; r < len; ++r ) {
+
+                    if ( !nextLine(begin, end) || end - begin != len ) {
+
+                        return malformed(lineNo, "a jigsaw needs " + std::to_string(len) + " rows of " +
+                                         std::to_string(len) + " region labels");
+                    }
+
+                    for ( int c = 0; c < len; ++c ) {
+
+                        unsigned char x = begin[c];
+                        if ( id[x] < 0 ) {
+                            id[x] = regions++;
+                        }
+                        if ( regions > len || ++cells[id[x]] > len ) {
+
+                            return malformed(lineNo, std::string("jigsaw region '") + begin[c] + "' is not " +
+                                             std::to_string(len) + " cells");
+                        }
+                        v->region[r * len + c] = id[x];
+                    }
+                }
+            } else if ( isWord(begin, space, "cage") ) {
+
+                std::istringstream in(std::string(space, end));
+                variant::cage k;
+                if ( !(in >> k.sum) ) {
+
+                    return malformed(lineNo, "a cage starts with its sum");
+                }
+
+                std::string cell;
+                while ( in >> cell ) {
+
+                    int r, c;
+                    char tail;
+                    if ( std::sscanf(cell.c_str(), "r%dc%d%c", &r, &c, &tail) != 2 ||
+                         r < 1 || r > len || c < 1 || c > len ) {
+
+                        return malformed(lineNo, "'" + cell + "' is not a cell like r1c1");
+                    }
+
+                    int x = (r - 1) * len + c - 1;
+                    if ( owner.empty() ) {
+                        owner.assign(len * len, -1);
+                    }
+                    if ( owner[x] >= 0 ) {
+
+                        return malformed(lineNo, cell + " is in two cages");
+                    }
+                    owner[x] = v->cages.size();
+                    k.cells.push_back(x);
+                }
+
+                int n = k.cells.size();
+                if ( n == 0 || n > len || k.sum < n * (n + 1) / 2 || k.sum > n * (2 * len - n + 1) / 2 ) {
+
+                    return malformed(lineNo, "no " + std::to_string(n) + " different symbols add up to " +
+                                     std::to_string(k.sum));
+                }
+                v->cages.push_back(k);
+            } else {
+
+                // the next puzzle or whatever else, left for the next read
+                at = atWas;
+                lineNo = lineWas;
+                return PUZZLE;
+            }
+        }
+    }
+
+    /**
+     * length of the next line, without reading it
+     * Helper Function
+     * @return int -1 at the end of the input
+     */
+    int peekLength() {
+
+        size_t atWas = at;
+        int lineWas = lineNo;
+        const char *begin, *end;
+        int n = nextLine(begin, end) ? end - begin : -1;
+        at = atWas;
+        lineNo = lineWas;
+
+        return n;
+    }
+
+    /**
+     * are the len lines from an offset on all bare rows of len cells, without reading them
+     * Helper Function
+     * @param from offset of the first line
+     * @param len board length
+     * @return bool
+     */
+    bool gridFollows(size_t from, int len) {
+
+        size_t atWas = at;
+        int lineWas = lineNo;
+        at = from;
+        const char *begin, *end;
+        int r = 0;
+        while ( r < len && nextLine(begin, end, true) && end - begin == len ) {
+            ++r;
+        }
+        at = atWas;
+        lineNo = lineWas;
+
+        return r == len;
+    }
+
+    /**
+     * skip what is left of a malformed grid, stopping at an empty line
+     * Helper Function
+     * @param rows rows left
+     */
+    void skipRows(int rows) {
+
+        const char *begin, *end;
+        while ( rows-- > 0 && peekLength() > 0 ) {
+            nextLine(begin, end);
+        }
+    }
+
+    /**
+     * copy the cells of one line, blanks become NOTFILLED
+     * Helper Function
+     * @param from the cells as they are on the line
+     * @param n cells on the line
+     * @param len board length
+     * @param to where they go
+     * @return bool false if a character is neither a symbol nor a blank
+     */
+    bool copyCells(const char *from, int n, int len, char *to) {
+
+        for ( int i = 0; i < n; ++i ) {
+
+            char v = from[i];
+            if ( v == '.' || v == NOTFILLED || ( v == '0' && len <= 9 ) ) {
+                v = NOTFILLED;
+            } else if ( !isSymbol(v, len) ) {
+
+                malformed(lineNo, "column " + std::to_string(i + 1) + " '" + v +
+                          "' is not a symbol of a " + std::to_string(len) + "x" + std::to_string(len) + " board");
+                return false;
+            }
+            to[i] = v;
+        }
+
+        return true;
+    }
+
+    /**
+     * note what is wrong
+     * Helper Function
+     * @param line line number
+     * @param what what is wrong
+     * @return readStatus MALFORMED
+     */
+    readStatus malformed(int line, const std::string &what) {
+
+        err = file + " line " + std::to_string(line) + ": " + what;
+        return MALFORMED;
+    }
+};
+
+/**
+ * read the first puzzle of a file, in any of the forms puzzleReader knows
+ * @param name file name, "-" for stdin
+ * @param rows the rows read
+ * @param v the variant of the puzzle, nullptr to drop it
+ * @return bool false if the file can not be read or holds no puzzle
+ */
+bool readPuzzle(const std::string &name, std::vector<std::string> &rows, variant *v = nullptr)
+{
+    puzzleReader in(name);
+    if ( !in.isOpen() ) {
+
+        std::cout << "error opening file " << name << std::endl;
+        return false;
+    }
+
+    char cells[MAXLEN * MAXLEN];
+    int len, lineNo;
+    readStatus st = in.next(cells, len, lineNo, v);
+    if ( st != PUZZLE ) {
+
+        std::cout << ( st == END ? name + " holds no puzzle" : in.error() ) << std::endl;
+        return false;
+    }
+
+    rows.clear();
+    for ( int r = 0; r < len; ++r ) {
+        rows.push_back(std::string(cells + r * len, len));
+    }
+
+    return true;
+}
+
+/**
+ * name of the solution file that goes with a puzzle file, x.txt is x_sol.txt
+ * @param name puzzle file name
+ * @return std::string
+ */
+std::string solutionName(const std::string &name)
+{
+    std::string base = name;
+    if ( base.size() > 4 && base.compare(base.size() - 4, 4, ".txt") == 0 ) {
+        base.erase(base.size() - 4);
+    }
+
+    return base + "_sol.txt";
+}
+
+/**
+ * the rows of a puzzle as one line
+ * @param rows the rows
+ * @return std::string
+ */
+std::string joinRows(const std::vector<std::string> &rows)
+{
+    std::string line;
+    for ( unsigned int r = 0; r < rows.size(); ++r ) {
+        line += rows[r];
+    }
+
+    return line;
+}
+
+/**
+ * check a solution against the expected one
+ * @param got the solution as one line
+ * @param expected the expected solution as one line
+ * @return std::string "match" or where the two part ways
+ */
+std::string verify(const std::string &got, const std::string &expected)
+{
+    if ( got.size() != expected.size() ) {
+
+        return "MISMATCH expected a " + std::to_string(expected.size()) + " cell board";
+    }
+
+    int len = 0;
+    while ( len * len < (int) got.size() ) {
+        ++len;
+    }
+
+    for ( unsigned int i = 0; i < got.size(); ++i ) {
+
+        if ( got[i] != expected[i] ) {
+
+            return "MISMATCH at row " + std::to_string(i / len + 1) +
+                   " column " + std::to_string(i % len + 1) +
+                   ", expected " + expected[i] + " got " + got[i];
+        }
+    }
+
+    return "match";
+}
+
+/**
+ * describe the number of solutions a count turned up
+ * @param found solutions found
+ * @param limit solutions looked for, 0 for all of them
+ * @return std::string
+ */
+std::string describeCount(long long found, long long limit)
+{
+    std::string d = std::to_string(found);
+    if ( limit != 0 && found >= limit && limit > 1 ) {
+        d += " or more";
+    }
+    if ( found == 1 && ( limit == 0 || limit > 1 ) ) {
+        d += " (unique)";
+    }
+
+    return d;
+}
+
+/**
+ * one puzzle of a batch and what became of it
+ * the cells are overwritten with the solution, the slots of a chunk are
+ * reused for the next one so streaming a batch allocates nothing per puzzle
+ */
+struct job {
+    std::string name;
+    std::string error;
+    int len = 0;
+    int lineNo = 0;
+    char cells[MAXLEN * MAXLEN];
+    variant var;
+    bool solved = false;
+    long long found = 0;
+    bool checked = false;
+    char expected[MAXLEN * MAXLEN];
+    metrics m;
+};
+
+/**
+ * what one thread of the batch keeps for itself
+ * a board instance per order, made on first use and reused after that,
+ * and the metrics of every puzzle it solved
+ */
+struct worker {
+    std::unique_ptr<Sudoku<2> > s2;
+    std::unique_ptr<Sudoku<3> > s3;
+    std::unique_ptr<Sudoku<4> > s4;
+    std::unique_ptr<Sudoku<5> > s5;
+    std::unique_ptr<Sudoku<6> > s6;
+    metrics m;
+    int puzzles = 0;
+};
+
+/**
+ * solve one job on the worker's board instance of its order
+ * @param s board instance, made if it does not exist yet
+ * @param j job
+ * @param opt how to solve
+ */
+template <int SUBLEN>
+void solveJob(std::unique_ptr<Sudoku<SUBLEN> > &s, job &j, const options &opt)
+{
+    if ( !s ) {
+        s.reset(new Sudoku<SUBLEN>);
+    }
+
+    if ( !j.var.empty() && opt.e != MASK && opt.e != ITER ) {
+
+        j.error = "variants need --engine=mask or --engine=iter";
+        return;
+    }
+
+    s->setVariant(j.var);
+    if ( s->load(j.cells) ) {
+
+        j.solved = s->solve(opt);
+        j.found = s->found;
+        std::memcpy(j.cells, s->cells(), j.len * j.len);
+    }
+    j.m = s->m;
+}
+
+/**
+ * where the puzzles of a batch come from
+ * the files of a directory, one puzzle each, or the puzzles of one stream
+ */
+struct batchInput {
+    std::string dir;
+    std::vector<std::string> files;
+    unsigned int nextFile = 0;
+    std::unique_ptr<puzzleReader> reader;
+    bool check = false;
+};
+
+/**
+ * open the input of a batch
+ * a directory holds one puzzle file each, the *_sol.txt files are skipped,
+ * anything else is a stream of puzzles, "-" being stdin
+ * @param name directory, file or "-"
+ * @param in the input
+ * @param check also read the *_sol.txt file of each puzzle file that has one
+ * @return bool false if the input can not be read
+ */
+bool openBatch(const std::string &name, batchInput &in, bool check)
+{
+    struct stat st;
+    in.check = check;
+    if ( name != "-" && stat(name.c_str(), &st) == 0 && S_ISDIR(st.st_mode) ) {
+
+        DIR *dir = opendir(name.c_str());
+        if ( dir == nullptr ) {
+
+            std::cout << "error opening directory " << name << std::endl;
+            return false;
+        }
+
+        while ( struct dirent *e = readdir(dir) ) {
+
+            std::string f = e->d_name;
+            if ( f.size() > 4 && f.compare(f.size() - 4, 4, ".txt") == 0 &&
+                 ( f.size() < 8 || f.compare(f.size() - 8, 8, "_sol.txt") != 0 ) ) {
+                in.files.push_back(f);
+            }
+        }
+        closedir(dir);
+
+        // directory order is whatever the file system likes
+        std::sort(in.files.begin(), in.files.end());
+        in.dir = name;
+        return true;
+    }
+
+    in.reader.reset(new puzzleReader(name));
+    if ( !in.reader->isOpen() ) {
+
+        std::cout << "error opening file " << name << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * read the next puzzle of a batch into a job slot
+ * a malformed puzzle still takes a slot, with its error, so it is reported in order
+ * @param in the input
+ * @param j job slot
+ * @return bool false at the end of the input
+ */
+bool readJob(batchInput &in, job &j)
+{
+    j.name.clear();
+    j.error.clear();
+    j.solved = false;
+    j.found = 0;
+    j.checked = false;
+    j.m = metrics();
+
+    readStatus st;
+    if ( in.reader ) {
+
+        st = in.reader->next(j.cells, j.len, j.lineNo, &j.var);
+        if ( st == END ) {
+            return false;
+        }
+        if ( st == MALFORMED ) {
+            j.error = in.reader->error();
+        }
+    } else {
+
+        if ( in.nextFile == in.files.size() ) {
+            return false;
+        }
+
+        j.name = in.files[in.nextFile++];
+        puzzleReader puzzle(in.dir + "/" + j.name);
+        st = puzzle.next(j.cells, j.len, j.lineNo, &j.var);
+        if ( st != PUZZLE ) {
+            j.error = st == END ? "no puzzle" : puzzle.error();
+        }
+
+        struct stat sb;
+        std::string solName = in.dir + "/" + solutionName(j.name);
+        if ( st == PUZZLE && in.check && stat(solName.c_str(), &sb) == 0 ) {
+
+            int len, lineNo;
+            puzzleReader sol(solName);
+            j.checked = sol.next(j.expected, len, lineNo) == PUZZLE && len == j.len;
+        }
+    }
+
+    if ( st != PUZZLE ) {
+        j.len = 0;
+    }
+
+    return true;
+}
+
+/**
+ * solve a batch of puzzles on a pool of threads
+ * the puzzles are read into a window of job slots, the threads take the next
+ * one off a shared counter and the solutions are printed one per line, in
+ * input order, as soon as the run of finished puzzles reaches them. a slot is
+ * read again as soon as it is printed, so one slow puzzle holds up its own
+ * line and no more, while the pool carries on with the rest of the window
+ * with check on, solutions that have a *_sol.txt file are compared against it
+ * @param name directory, file or "-"
+ * @param opt how to solve
+ * @param varOpt how to solve the puzzles that carry a variant
+ * @param threads pool size
+ * @param check verify against the solution files
+ * @return int exit code
+ */
+int runBatch(const std::string &name, const options &opt, const options &varOpt, int threads, bool check)
+{
+    const long long WINDOW = 1024;
+
+    batchInput in;
+    if ( !openBatch(name, in, check) ) {
+
+        return 1;
+    }
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+    std::vector<worker> workers(threads);
+    std::vector<job> jobs(WINDOW);
+    std::vector<char> done(WINDOW, 0);
+    std::mutex mtx;
+    std::condition_variable cv;
+    long long read = 0, taken = 0;
+    bool eof = false;
+
+    std::vector<std::thread> pool;
+    for ( int t = 0; t < threads; ++t ) {
+
+        pool.push_back(std::thread([&, t]() {
+
+            worker &w = workers[t];
+            std::unique_lock<std::mutex> lock(mtx);
+            while ( true ) {
+
+                cv.wait(lock, [&]() { return taken < read || eof; });
+                if ( taken == read ) {
+                    return;
+                }
+                long long i = taken++;
+                lock.unlock();
+
+                // the slot is not read into again until it is printed
+                job &j = jobs[i % WINDOW];
+                const options &o = j.var.empty() ? opt : varOpt;
+                switch ( j.len ) {
+                    case 4 : solveJob(w.s2, j, o); break;
+                    case 9 : solveJob(w.s3, j, o); break;
+                    case 16 : solveJob(w.s4, j, o); break;
+                    case 25 : solveJob(w.s5, j, o); break;
+                    case 36 : solveJob(w.s6, j, o); break;
+                    default : break;
+                }
+                if ( j.len != 0 ) {
+                    accumulate(w.m, j.m);
+                    ++w.puzzles;
+                }
+
+                lock.lock();
+                done[i % WINDOW] = 1;
+                cv.notify_all();
+            }
+        }));
+    }
+
+    // fill the free slots, then print the oldest puzzle once it is done, and again
+    long long puzzles = 0, solved = 0, unique = 0, mismatched = 0, malformed = 0;
+    while ( true ) {
+
+        while ( !eof && read - puzzles < WINDOW ) {
+
+            bool more = readJob(in, jobs[read % WINDOW]);
+            std::lock_guard<std::mutex> lock(mtx);
+            if ( more ) {
+                ++read;
+            } else {
+                eof = true;
+            }
+            cv.notify_all();
+        }
+        if ( puzzles == read ) {
+            break;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [&]() { return done[puzzles % WINDOW] != 0; });
+            done[puzzles % WINDOW] = 0;
+        }
+
+        job &j = jobs[puzzles % WINDOW];
+        ++puzzles;
+        if ( !j.name.empty() ) {
+            std::cout << j.name << " ";
+        }
+        if ( j.len == 0 ) {
+            std::cout << "malformed " << j.error << '\n';
+            ++malformed;
+            continue;
+        }
+        if ( j.solved ) {
+            std::cout.write(j.cells, j.len * j.len);
+            ++solved;
+        } else {
+            std::cout << ( j.error.empty() ? "no solution" : j.error );
+        }
+
+        if ( opt.limit != 1 ) {
+
+            std::cout << " " << describeCount(j.found, opt.limit);
+            if ( j.found == 1 ) {
+                ++unique;
+            }
+        }
+
+        if ( j.checked ) {
+
+            std::string v = verify(std::string(j.cells, j.len * j.len),
+                                   std::string(j.expected, j.len * j.len));
+            std::cout << " " << v;
+            if ( v != "match" ) {
+                ++mismatched;
+            }
+        }
+        std::cout << '\n';
+    }
+
+    for ( unsigned int t = 0; t < pool.size(); ++t ) {
+        pool[t].join();
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    metrics total;
+    std::cout << std::endl;
+    for ( int t = 0; t < threads; ++t ) {
+
+        std::cout << " Thread " << t << " |  Puzzles : " << workers[t].puzzles << std::endl;
+        printMetrics(workers[t].m);
+        std::cout << std::endl;
+        accumulate(total, workers[t].m);
+    }
+
+    std::cout << std::endl << " Batch " << " |  Puzzles : " << puzzles <<
+              " | Solved : " << solved <<
+              " | Malformed : " << malformed <<
+              " | Threads : " << threads <<
+              " | Elapsed : " << elapsed << " seconds" <<
+              " | Puzzles/sec : " << ( elapsed > 0 ? puzzles / elapsed : 0 ) << std::endl;
+    if ( opt.limit != 1 ) {
+        std::cout << " Unique : " << unique << " | Not unique : " << solved - unique << std::endl;
+    }
+    if ( check ) {
+        std::cout << " Mismatched : " << mismatched << std::endl;
+    }
+    printMetrics(total);
+    std::cout << std::endl;
+
+    return solved == puzzles && mismatched == 0 ? 0 : 1;
+}
+
+/**
+ * a subtree of the parallel search, the board at its root as one line
+ */
+struct task {
+    std::string board;
+    int depth;
+};
+
+/**
+ * tasks of one worker of the parallel search
+ * the owner pushes and pops at the back, depth first,
+ * idle workers steal from the front where the bigger subtrees are
+ */
+struct taskQueue {
+    std::mutex mtx;
+    std::deque<task> q;
+};
+
+/**
+ * what one worker of the parallel search did
+ */
+struct searchWorker {
+    metrics m;
+    int tasks = 0;
+    int steals = 0;
+};
+
+/**
+ * compare a solution with the one in a file and print how it went
+ * @param line the solution, row after row
+ * @param solName solution file
+ * @return int exit code, 0 on a match
+ */
+int verifyWith(const std::string &line, const std::string &solName)
+{
+    std::vector<std::string> sol;
+    if ( !readPuzzle(solName, sol) ) {
+
+        return 1;
+    }
+
+    std::string v = verify(line, joinRows(sol));
+    std::cout << std::endl << " Verified : " << v << " with " << solName << std::endl;
+
+    return v == "match" ? 0 : 1;
+}
+
+/**
+ * solve one puzzle on a pool of threads
+ * tasks shallower than depth are split into one child per candidate of
+ * the chosen cell, deeper ones are searched to the bottom by the MASK engine
+ * a worker runs out of its own queue first and then steals from the others,
+ * with nothing to steal it sleeps until tasks are queued or the search is over
+ * the first solution stops every worker unless the count asks for more
+ * @param rows the puzzle
+ * @param var its variant
+ * @param opt how to solve, the engine is MASK or ITER
+ * @param threads pool size
+ * @param depth levels of the tree that are split into tasks
+ * @param solName solution file to compare the first solution against, empty for none
+ * @return int exit code
+ */
+template <int SUBLEN>
+int runParallel(const std::vector<std::string> &rows, const variant &var, const options &opt, int threads, int depth,
+                const std::string &solName)
+{
+    std::unique_ptr<Sudoku<SUBLEN> > root(new Sudoku<SUBLEN>);
+    root->setVariant(var);
+    if ( !root->load(rows) ) {
+
+        std::cout << "puzzle has a symbol outside of " << Sudoku<SUBLEN>::SYM <<
+                  " for its size" << std::endl;
+        return 1;
+    }
+
+    // print the problem Sudoku Puzzle first
+    std::cout << std::endl << std::endl << "The Sudoku Puzzle" << std::endl << std::endl;
+    root->print();
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+    std::vector<taskQueue> queues(threads);
+    std::vector<searchWorker> workers(threads);
+    std::atomic<int> pending(1);
+    std::atomic<int> queued(1);
+    std::mutex idleMtx;
+    std::condition_variable idle;
+    std::atomic<long long> found(0);
+    std::atomic<bool> stop(false);
+    std::mutex firstMtx;
+    std::string first;
+
+    task t;
+    t.board = root->line();
+    t.depth = 0;
+    queues[0].q.push_back(t);
+
+    std::vector<std::thread> pool;
+    for ( int me = 0; me < threads; ++me ) {
+
+        pool.push_back(std::thread([&, me]() {
+
+            std::unique_ptr<Sudoku<SUBLEN> > s(new Sudoku<SUBLEN>);
+            s->setVariant(var);
+            s->sharedFound = &found;
+            s->stop = &stop;
+            searchWorker &w = workers[me];
+            std::vector<std::string> children;
+
+            while ( true ) {
+
+                task t;
+                bool got = false;
+                {
+                    std::lock_guard<std::mutex> lock(queues[me].mtx);
+                    if ( !queues[me].q.empty() ) {
+                        t = std::move(queues[me].q.back());
+                        queues[me].q.pop_back();
+                        --queued;
+                        got = true;
+                    }
+                }
+
+                for ( int k = 1; !got && k < threads; ++k ) {
+
+                    taskQueue &victim = queues[(me + k) % threads];
+                    std::lock_guard<std::mutex> lock(victim.mtx);
+                    if ( !victim.q.empty() ) {
+                        t = std::move(victim.q.front());
+                        victim.q.pop_front();
+                        --queued;
+                        got = true;
+                        ++w.steals;
+                    }
+                }
+
+                if ( !got ) {
+
+                    // nothing queued and nothing running that could queue more
+                    if ( pending == 0 ) {
+                        break;
+                    }
+                    std::unique_lock<std::mutex> lock(idleMtx);
+                    idle.wait(lock, [&]() { return queued > 0 || pending == 0; });
+                    continue;
+                }
+
+                if ( !stop ) {
+
+                    s->load(t.board);
+                    if ( t.depth < depth ) {
+
+                        children.clear();
+                        s->split(opt, children);
+
+                        // pushed in reverse so the first candidate comes off the back first
+                        pending += (int) children.size();
+                        {
+                            std::lock_guard<std::mutex> lock(queues[me].mtx);
+                            for ( int c = (int) children.size() - 1; c >= 0; --c ) {
+
+                                task child;
+                                child.board = std::move(children[c]);
+                                child.depth = t.depth + 1;
+                                queues[me].q.push_back(std::move(child));
+                            }
+                        }
+
+                        // taken under the lock the sleepers wait on, so none of them misses it
+                        queued += (int) children.size();
+                        std::lock_guard<std::mutex> lock(idleMtx);
+                        idle.notify_all();
+                    } else {
+
+                        s->solve(opt);
+                    }
+
+                    accumulate(w.m, s->m);
+                    ++w.tasks;
+
+                    if ( s->found > 0 ) {
+
+                        std::lock_guard<std::mutex> lock(firstMtx);
+                        if ( first.empty() ) {
+                            first = s->first;
+                        }
+                    }
+                }
+
+                if ( --pending == 0 ) {
+
+                    std::lock_guard<std::mutex> lock(idleMtx);
+                    idle.notify_all();
+                }
+            }
+        }));
+    }
+
+    for ( unsigned int i = 0; i < pool.size(); ++i ) {
+        pool[i].join();
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    metrics total;
+    for ( int i = 0; i < threads; ++i ) {
+        accumulate(total, workers[i].m);
+    }
+
+    int rc = 1;
+    if ( !first.empty() ) {
+
+        root->load(first);
+        root->m = total;
+        std::cout << std::endl << std::endl << "The Sudoku Puzzle Solution" << std::endl << std::endl;
+        root->print();
+        rc = 0;
+    }
+
+    std::cout << std::endl << std::endl;
+    for ( int i = 0; i < threads; ++i ) {
+
+        std::cout << " Worker " << i << " |  Tasks : " << workers[i].tasks <<
+                  " | Steals : " << workers[i].steals <<
+                  " | Nodes : " << workers[i].m.iterations <<
+                  " | Backtracked : " << workers[i].m.backtracked << std::endl;
+    }
+
+    // the last few solutions may land after another worker hit the limit
+    long long solutions = opt.limit != 0 ? std::min<long long>(found, opt.limit) : (long long) found;
+    std::cout << " Parallel " << " |  Threads : " << threads <<
+              " | Split depth : " << depth <<
+              " | Solutions : " << solutions <<
+              " | Elapsed : " << elapsed << " seconds" << std::endl;
+
+    if ( rc == 0 && !solName.empty() ) {
+
+        return verifyWith(first, solName);
+    }
+
+    return rc;
+}
+
+/**
+ * solve the puzzle with the board instance that fits its order
+ * @param rows the puzzle
+ * @param var its variant
+ * @param opt how to solve
+ * @param solName solution file to compare against, empty for none
+ * @return int exit code
  */
-constexpr int LEN = 16;
-//constexpr int LEN = 9;
+template <int SUBLEN>
+int run(const std::vector<std::string> &rows, const variant &var, const options &opt, const std::string &solName)
+{
+    std::unique_ptr<Sudoku<SUBLEN> > s(new Sudoku<SUBLEN>);
+    s->setVariant(var);
+    if ( !s->load(rows) ) {
+
+        std::cout << "puzzle has a symbol outside of " << Sudoku<SUBLEN>::SYM <<
+                  " for its size" << std::endl;
+        return 1;
+    }
+
+    // print the problem Sudoku Puzzle first
+    std::cout << std::endl << std::endl << "The Sudoku Puzzle" << std::endl << std::endl;
+    s->print();
+
+    // solve the puzzle
+    bool solved = s->solve( opt );
+    if ( solved ) {
+
+        std::cout << std::endl << std::endl << "The Sudoku Puzzle Solution" << std::endl << std::endl;
+
+        s->print();
+    }
+
+    if ( opt.limit != 1 ) {
+
+        std::cout << std::endl << " Solutions : " << describeCount(s->found, opt.limit) << std::endl;
+    }
+
+    if ( opt.slice != 0 ) {
+
+        std::cout << std::endl << " Pauses : " << s->pauses << std::endl;
+    }
+
+    if ( solved && !solName.empty() ) {
+
+        return verifyWith(s->line(), solName);
+    }
+
+    return solved ? 0 : 1;
+}
 
 /**
- * for the 4X4 grid
+ * the grades of the generator, easiest first
+ * easy needs naked singles only, medium hidden singles as well, hard pairs
+ * or pointing and claiming, evil a few guesses and extreme more than that
  */
-constexpr int SUBLEN = 4;
-//constexpr int SUBLEN = 3;
+const char *const GRADES[] = { "easy", "medium", "hard", "evil", "extreme" };
+const int GRADE_COUNT = 5;
 
 /**
- * symbols used are unique -- hex values
+ * grade a puzzle by what the ITER engine with MRV and propagation needed
+ * without a guess by the hardest rule it took, with guesses by how much of
+ * the search went to waste. up to 9x9 a few guesses are up to LEN + 1 taken
+ * back; from 16x16 on one wrong guess takes back far more, so there the rule
+ * counts decide: a few guesses place at most two singles for every blank
+ * @param m metrics of solving the puzzle
+ * @param len LEN of the board
+ * @param blanks empty cells of the puzzle
+ * @return int index into GRADES
  */
-//const std::set<char> sym {'0','1','2','3','4','5','6','7','8','9','A','B','C','D','E','F'};
-//const std::set<char> sym {'1','2','3','4','5','6','7','8','9'};
-const char sym[16] = {'0','1','2','3','4','5','6','7','8','9','A','B','C','D','E','F'};
-//const char sym[9] = {'1','2','3','4','5','6','7','8','9'};
+int grade(const metrics &m, int len, int blanks)
+{
+    if ( m.iterations > 1 ) {
+
+        if ( len > 9 ) {
+            return m.nakedSingles + m.hiddenSingles <= 2 * blanks ? 3 : 4;
+        }
+        return m.backtracked <= len + 1 ? 3 : 4;
+    }
+
+    if ( m.nakedPairs + m.hiddenPairs + m.pointing + m.claiming > 0 ) {
+
+        return 2;
+    }
+
+    return m.hiddenSingles > 0 ? 1 : 0;
+}
+
 /**
- * character indicating that the position is not filled
+ * one generated puzzle
  */
-const char NOTFILLED = '-';
+struct generated {
+    std::string clues;
+    int givens = 0;
+    int grade = 0;
+    int attempts = 0;
+    metrics m;
+};
 
 /**
- *  hold the metrics
+ * make a random full board
+ * the boxes on the diagonal do not see each other so they are filled with
+ * shuffled symbols, the solver fills in the rest and the result is
+ * shuffled once more by bands, stacks, rows, columns and a transpose
+ * @param s board instance
+ * @param rng random numbers
+ * @return bool false if the solver gave up, the caller tries again
  */
-struct metrics {
-    int maxStackHeight = -1;
-    int backtracked = 0;
-    int iterations = 0;
-} m;
+template <int SUBLEN>
+bool fullBoard(Sudoku<SUBLEN> &s, std::mt19937 &rng)
+{
+    const int LEN = Sudoku<SUBLEN>::LEN;
+
+    std::string line(LEN * LEN, NOTFILLED);
+    std::string sym(Sudoku<SUBLEN>::SYM, LEN);
+    for ( int x = 0; x < SUBLEN; ++x ) {
+
+        std::shuffle(sym.begin(), sym.end(), rng);
+        for ( int i = 0; i < LEN; ++i ) {
+
+            int r = x * SUBLEN + i / SUBLEN, c = x * SUBLEN + i % SUBLEN;
+            line[r * LEN + c] = sym[i];
+        }
+    }
+
+    options opt;
+    opt.e = ITER;
+    opt.h = MRV;
+    opt.rules = true;
+    opt.singlesOnly = true;
+    s.load(line);
+    if ( !s.solveWithin(opt, 100 * LEN) || s.found == 0 ) {
+
+        return false;
+    }
+
+    // bands and the rows inside them, the same for stacks and columns
+    int row[LEN], col[LEN], band[SUBLEN], stack[SUBLEN];
+    for ( int x = 0; x < SUBLEN; ++x ) {
+        band[x] = stack[x] = x;
+    }
+    std::shuffle(band, band + SUBLEN, rng);
+    std::shuffle(stack, stack + SUBLEN, rng);
+    for ( int x = 0; x < SUBLEN; ++x ) {
+
+        for ( int i = 0; i < SUBLEN; ++i ) {
 
+            row[x * SUBLEN + i] = band[x] * SUBLEN + i;
+            col[x * SUBLEN + i] = stack[x] * SUBLEN + i;
+        }
+        std::shuffle(row + x * SUBLEN, row + (x + 1) * SUBLEN, rng);
+        std::shuffle(col + x * SUBLEN, col + (x + 1) * SUBLEN, rng);
+    }
+
+    bool transpose = rng() & 1;
+    std::string solved = s.line();
+    for ( int r = 0; r < LEN; ++r ) {
+        for ( int c = 0; c < LEN; ++c ) {
+
+            char v = solved[row[r] * LEN + col[c]];
+            line[transpose ? c * LEN + r : r * LEN + c] = v;
+        }
+    }
+    s.load(line);
+
+    return true;
+}
 
 /**
- * Iterate through the sub board and check for the value
- * Helper Function
- * @param b address of the board
- * @param subR sub board row
- * @param subC sub board column
- * @param v value
- * @return bool
+ * make one puzzle
+ * the clues of a random full board are taken away in random order, each
+ * one only if the puzzle still has a single solution, until none can go
+ * the puzzle is then graded, with a wanted grade the whole thing repeats
+ * until it comes out at that grade or the tries run out
+ * the random numbers come from the seed and the puzzle number alone so a
+ * run can be repeated with any number of threads
+ * @param s board instance, made if it does not exist yet
+ * @param p the puzzle
+ * @param seed seed of the run
+ * @param index puzzle number
+ * @param want wanted grade, -1 for any
  */
-bool inSubBoard(char b[LEN][LEN], int subR, int subC, char v)
+template <int SUBLEN>
+void generateOne(std::unique_ptr<Sudoku<SUBLEN> > &s, generated &p, unsigned int seed, unsigned int index, int want)
 {
-    for (int r = 0; r < SUBLEN; r++) {
+    const int LEN = Sudoku<SUBLEN>::LEN;
+    const int TRIES = 1000;
+
+    if ( !s ) {
+        s.reset(new Sudoku<SUBLEN>);
+    }
 
-        for (int c = 0; c < SUBLEN; c++) {
+    // uniqueness is checked by the singles at the root alone, a clue that
+    // needs a guess to prove it can go stays, which is cheaper than looking
+    // and keeps every check to one propagation whatever the size of the board.
+    // the clues come off one grid kept for the whole board, see digOut()
+    const long long BUDGET = 1;
+    options opt;
+    opt.e = ITER;
+    opt.h = MRV;
+    opt.rules = true;
+    opt.singlesOnly = true;
 
-            if (b[r + subR][c + subC] == v) {
+    // the grade counts every rule
+    options full = opt;
+    full.singlesOnly = false;
 
-                return true;
+    std::seed_seq seq = { seed, index };
+    std::mt19937 rng(seq);
+
+    int order[LEN * LEN];
+    for ( int i = 0; i < LEN * LEN; ++i ) {
+        order[i] = i;
+    }
+
+    for ( p.attempts = 1; p.attempts <= TRIES; ++p.attempts ) {
+
+        while ( !fullBoard(*s, rng) ) {
+        }
+
+        p.givens = LEN * LEN;
+        std::shuffle(order, order + LEN * LEN, rng);
+        s->beginDig();
+        for ( int i = 0; i < LEN * LEN; ++i ) {
+
+            if ( s->digOut(opt, order[i], BUDGET) ) {
+                --p.givens;
             }
         }
-    }
 
-    return false;
+        std::string clues = s->line();
+        s->load(clues);
+        s->solve(full);
+
+        p.clues = clues;
+        p.m = s->m;
+        p.grade = grade(s->m, LEN, LEN * LEN - p.givens);
+        if ( want < 0 || p.grade == want ) {
+
+            return;
+        }
+    }
+    --p.attempts;
 }
 
 /**
- * Iterate through the entire row of the board and check for the value
- * Helper Function
- * @param b address of the board
- * @param r row
- * @param v value
- * @return bool
+ * generate puzzles on a pool of threads, printed one per line in order
+ * as the puzzle, its grade and the number of givens, blanks as '.',
+ * which --batch reads back in
+ * @param count puzzles to make
+ * @param sublen order of the puzzles
+ * @param seed seed of the run
+ * @param want wanted grade, -1 for any
+ * @param threads pool size
+ * @return int exit code
  */
-bool inRow(char b[LEN][LEN], int r, char v)
+int runGenerate(int count, int sublen, unsigned int seed, int want, int threads)
 {
-    for (int c = 0; c < LEN; c++) {
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
 
-        if ( b[r][c] == v) {
+    std::vector<generated> puzzles(count);
+    std::vector<worker> workers(threads);
+    std::vector<char> done(count, 0);
+    std::atomic<int> next(0);
+    std::mutex mtx;
+    std::condition_variable cv;
 
-            return true;
+    std::vector<std::thread> pool;
+    for ( int t = 0; t < threads; ++t ) {
+
+        pool.push_back(std::thread([&, t]() {
+
+            worker &w = workers[t];
+            for ( int i = next++; i < count; i = next++ ) {
+
+                generated &p = puzzles[i];
+                switch ( sublen ) {
+                    case 2 : generateOne(w.s2, p, seed, i, want); break;
+                    case 3 : generateOne(w.s3, p, seed, i, want); break;
+                    case 4 : generateOne(w.s4, p, seed, i, want); break;
+                    case 5 : generateOne(w.s5, p, seed, i, want); break;
+                    case 6 : generateOne(w.s6, p, seed, i, want); break;
+                    default : break;
+                }
+                accumulate(w.m, p.m);
+                ++w.puzzles;
+
+                std::lock_guard<std::mutex> lock(mtx);
+                done[i] = 1;
+                cv.notify_all();
+            }
+        }));
+    }
+
+    // print in order while the pool works on the rest
+    int graded[GRADE_COUNT] = { 0 };
+    long long givens = 0;
+    int missed = 0;
+    for ( int i = 0; i < count; ++i ) {
+
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [&]() { return done[i] != 0; });
         }
+
+        generated &p = puzzles[i];
+        std::replace(p.clues.begin(), p.clues.end(), NOTFILLED, '.');
+        std::cout << p.clues << " " << GRADES[p.grade] << " " << p.givens << std::endl;
+
+        ++graded[p.grade];
+        givens += p.givens;
+        if ( want >= 0 && p.grade != want ) {
+            ++missed;
+        }
+        std::string().swap(p.clues);
+    }
+
+    for ( unsigned int t = 0; t < pool.size(); ++t ) {
+        pool[t].join();
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    metrics total;
+    for ( int t = 0; t < threads; ++t ) {
+        accumulate(total, workers[t].m);
     }
 
-    return false;
+    std::cout << std::endl << " Generate " << " |  Puzzles : " << count <<
+              " | Seed : " << seed <<
+              " | Threads : " << threads <<
+              " | Elapsed : " << elapsed << " seconds" <<
+              " | Puzzles/sec : " << ( elapsed > 0 ? count / elapsed : 0 ) << std::endl;
+    std::cout << " Grades ";
+    for ( int g = 0; g < GRADE_COUNT; ++g ) {
+        std::cout << ( g == 0 ? " |  " : " | " ) << GRADES[g] << " : " << graded[g];
+    }
+    std::cout << " | Average givens : " << ( count > 0 ? (double) givens / count : 0 ) << std::endl;
+    if ( missed > 0 ) {
+        std::cout << " " << missed << " puzzles did not come out at the wanted grade" << std::endl;
+    }
+    printMetrics(total);
+    std::cout << std::endl;
+
+    return missed == 0 ? 0 : 1;
 }
 
 /**
- * Iterate through the entire column of the board and check for the value
- * Helper Function
- * @param b address of the board
- * @param c column
- * @param v value
- * @return bool
+ * name of a solver mode as the benchmark reports it
+ * @param opt how to solve
+ * @return std::string like "iter/mrv+rules"
  */
-bool inColumn(char b[LEN][LEN], int c, char v)
+std::string modeName(const options &opt)
 {
-    for (int r = 0; r < LEN; r++) {
+    static const char *const ENGINES[] = { "scan", "mask", "dlx", "iter" };
 
-        if ( b[r][c] == v) {
+    std::string name = ENGINES[opt.e];
+    if ( opt.e == MASK || opt.e == ITER ) {
 
-            return true;
+        name += opt.h == MRV ? "/mrv" : "/first";
+        if ( opt.rules ) {
+            name += "+rules";
         }
     }
 
-    return false;
+    return name;
 }
 
 /**
- * Helps to identify the co-ordinate on the board that needs to be updated
- * Helper Function
- * @param b address of the board
- * @param r a reference to the row to maintain the right address during recursion
- * @param c a reference to the column  to maintain the right address during recursion
- * @return bool
+ * timings of one puzzle in one solver mode
+ * times are in seconds, the counters come from the last repetition,
+ * every repetition does the same search
+ */
+struct benchResult {
+    std::string puzzle;
+    std::string mode;
+    int len = 0;
+    bool solved = false;
+    int reps = 0;
+    double median = 0;
+    double p99 = 0;
+    double mean = 0;
+    int nodes = 0;
+    int backtracked = 0;
+};
+
+/**
+ * time one puzzle in one solver mode
+ * the warmup runs are thrown away, the clock only runs around solve()
+ * @param rows the puzzle
+ * @param var its variant
+ * @param opt how to solve
+ * @param warmup runs before timing
+ * @param reps timed runs
+ * @param r the result
  */
-bool isNotFilled(char b[LEN][LEN], int &r, int &c)
+template <int SUBLEN>
+void benchPuzzle(const std::vector<std::string> &rows, const variant &var, const options &opt,
+                 int warmup, int reps, benchResult &r)
 {
-    for (r = 0; r < LEN; r++) {
-        for (c = 0; c < LEN; c++) {
-            if (b[r][c] == NOTFILLED) {
-                return true;
-            }
+    std::unique_ptr<Sudoku<SUBLEN> > s(new Sudoku<SUBLEN>);
+    s->setVariant(var);
+    std::vector<double> times;
+    for ( int i = 0; i < warmup + reps; ++i ) {
+
+        s->load(rows);
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        r.solved = s->solve(opt);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        if ( i >= warmup ) {
+            times.push_back(elapsed);
         }
     }
 
-    return false;
+    std::sort(times.begin(), times.end());
+    int n = times.size();
+    r.len = Sudoku<SUBLEN>::LEN;
+    r.reps = n;
+    r.median = n % 2 ? times[n / 2] : ( times[n / 2 - 1] + times[n / 2] ) / 2;
+
+    // nearest rank
+    r.p99 = times[( 99 * n + 99 ) / 100 - 1];
+    double sum = 0;
+    for ( int i = 0; i < n; ++i ) {
+        sum += times[i];
+    }
+    r.mean = sum / n;
+    r.nodes = s->m.iterations;
+    r.backtracked = s->m.backtracked;
 }
 
 /**
- * check if the value is on the subBoard or the column or row of the co-ordinate r,c
- * its legal if the value is not there on the three constraints
- * Helper Function
- * @param b address of the board
- * @param r row
- * @param c column
- * @param v value
- * @return bool
+ * quote a string for JSON
+ * @param v string
+ * @return std::string
  */
-bool isLegal(char b[LEN][LEN], int r, int c, char v)
+std::string jsonString(const std::string &v)
 {
+    std::string q = "\"";
+    for ( unsigned int i = 0; i < v.size(); ++i ) {
 
-    /**
-     *  (r  - r%SUBLEN, c - c%SUBLEN ) gives the top left of the Sub Board.
-     */
+        if ( v[i] == '"' || v[i] == '\\' ) {
+            q += '\\';
+        }
+        q += v[i];
+    }
 
-    return
-            !inRow(b,r,v) &&
-            !inColumn(b,c,v) &&
-            !inSubBoard(b,r - r%SUBLEN, c - c%SUBLEN,v);
+    return q + "\"";
 }
 
 /**
- * the actual work comes together here
- *
- * @param b
- * @return
+ * write the benchmark results as CSV, one line per puzzle and mode
+ * @param name file name
+ * @param results results
+ * @return bool false if the file can not be written
  */
-bool work(char b[LEN][LEN])
+bool writeCsv(const std::string &name, const std::vector<benchResult> &results)
 {
-    int r = 0, c = 0;
-    ++m.iterations;
-    ++m.maxStackHeight;
+    std::ofstream ofs(name.c_str());
+    if ( !ofs.is_open() ) {
 
-    // at this point the puzzle is solved
-    if ( !isNotFilled(b, r, c) ) {
-
-        return true;
+        std::cout << "error opening file " << name << std::endl;
+        return false;
     }
 
-    // iterate through the allowed symbols
-//    for ( auto it = sym.begin(); it != sym.end(); ++it ) {
-    for ( int i = 0; i < LEN; ++i ) {
+    ofs << "puzzle,mode,size,solved,reps,median_ms,p99_ms,mean_ms,nodes,nodes_per_sec,backtracked\n";
+    for ( unsigned int i = 0; i < results.size(); ++i ) {
 
-        // v is a possible candidate during traversal
-//        char v = *it;
-        char v = sym[i];
-        if ( isLegal(b, r, c, v) )
-        {
-            b[r][c] = v;
+        const benchResult &r = results[i];
+        ofs << r.puzzle << "," << r.mode << "," << r.len << "," << ( r.solved ? 1 : 0 ) << "," << r.reps << "," <<
+            r.median * 1e3 << "," << r.p99 * 1e3 << "," << r.mean * 1e3 << "," << r.nodes << "," <<
+            ( r.median > 0 ? r.nodes / r.median : 0 ) << "," << r.backtracked << "\n";
+    }
 
-            // if filled by the next move and passed the three
-            // constraints then v is the correct choice
-            if ( work(b) ) {
+    return true;
+}
 
-                return true;
+/**
+ * write the benchmark results as JSON, the settings and one object per puzzle and mode
+ * @param name file name
+ * @param results results
+ * @param warmup runs before timing
+ * @param reps timed runs
+ * @return bool false if the file can not be written
+ */
+bool writeJson(const std::string &name, const std::vector<benchResult> &results, int warmup, int reps)
+{
+    std::ofstream ofs(name.c_str());
+    if ( !ofs.is_open() ) {
 
-            }
+        std::cout << "error opening file " << name << std::endl;
+        return false;
+    }
 
-            // at this point v failed to meet the constraints and is set to NOTFILLED
-            // this propagates the recursion to traverse back one step
-            // and try from the address of r and c on the recursion stack
-            b[r][c] = NOTFILLED;
-            ++m.backtracked;
-            --m.maxStackHeight;
+    ofs << "{\n  \"warmup\": " << warmup << ",\n  \"reps\": " << reps << ",\n  \"results\": [";
+    for ( unsigned int i = 0; i < results.size(); ++i ) {
 
-        }
+        const benchResult &r = results[i];
+        ofs << ( i == 0 ? "\n" : ",\n" ) <<
+            "    { \"puzzle\": " << jsonString(r.puzzle) <<
+            ", \"mode\": " << jsonString(r.mode) <<
+            ", \"size\": " << r.len <<
+            ", \"solved\": " << ( r.solved ? "true" : "false" ) <<
+            ", \"median_ms\": " << r.median * 1e3 <<
+            ", \"p99_ms\": " << r.p99 * 1e3 <<
+            ", \"mean_ms\": " << r.mean * 1e3 <<
+            ", \"nodes\": " << r.nodes <<
+            ", \"nodes_per_sec\": " << ( r.median > 0 ? r.nodes / r.median : 0 ) <<
+            ", \"backtracked\": " << r.backtracked << " }";
     }
-    return false;
-}
+    ofs << "\n  ]\n}\n";
 
+    return true;
+}
 
 /**
- * Print the board
- * @param b board
+ * time every solver mode on every puzzle of a directory or a file, one thread
+ * so the timings do not fight over the cores
+ * without an engine on the command line every mode is run, SCAN is
+ * left out when solutions are counted since it can not count
+ * @param name directory, file or "-", read like a batch
+ * @param opt how to solve, when given on the command line
+ * @param all run every mode instead of opt
+ * @param warmup runs before timing
+ * @param reps timed runs
+ * @param csv CSV file to write, empty for none
+ * @param json JSON file to write, empty for none
+ * @return int exit code
  */
-void print(char b[LEN][LEN])
+int runBench(const std::string &name, const options &opt, bool all, int warmup, int reps,
+             const std::string &csv, const std::string &json)
 {
-    std::cout << std::endl;
+    std::vector<options> modes;
+    if ( all ) {
 
-    for (int r = 0; r < LEN; ++r)
-    {
-        for (int c = 0; c < LEN; ++c) {
+        options o;
+        o.limit = opt.limit;
+        if ( o.limit == 1 ) {
+            modes.push_back(o);
+        }
+
+        o.e = MASK;
+        modes.push_back(o);
+        o.h = MRV;
+        modes.push_back(o);
+        o.rules = true;
+        modes.push_back(o);
+        o.e = ITER;
+        modes.push_back(o);
+
+        o = options();
+        o.e = DLX;
+        o.limit = opt.limit;
+        modes.push_back(o);
+    } else {
+        modes.push_back(opt);
+    }
+
+    batchInput in;
+    if ( !openBatch(name, in, false) ) {
 
-            std::cout << b[r][c];
+        return 1;
+    }
+
+    // one puzzle at a time, in input order
+    job j;
+    std::vector<benchResult> results;
+    std::vector<double> modeTime(modes.size(), 0);
+    std::vector<long long> modeNodes(modes.size(), 0);
+    std::vector<int> modeSolved(modes.size(), 0);
+    int puzzles = 0;
+    while ( readJob(in, j) ) {
+
+        std::string puzzle = j.name.empty() ? name + ":" + std::to_string(j.lineNo) : j.name;
+        if ( j.len == 0 ) {
+
+            std::cout << puzzle << " malformed " << j.error << std::endl;
+            continue;
         }
 
-        std::cout << std::endl;
+        std::vector<std::string> rows;
+        for ( int r = 0; r < j.len; ++r ) {
+            rows.push_back(std::string(j.cells + r * j.len, j.len));
+        }
+        ++puzzles;
+
+        for ( unsigned int k = 0; k < modes.size(); ++k ) {
+
+            // only the MASK and ITER engines know the variants
+            if ( !j.var.empty() && modes[k].e != MASK && modes[k].e != ITER ) {
+                continue;
+            }
+
+            benchResult r;
+            r.puzzle = puzzle;
+            r.mode = modeName(modes[k]);
+            switch ( j.len ) {
+                case 4 : benchPuzzle<2>(rows, j.var, modes[k], warmup, reps, r); break;
+                case 9 : benchPuzzle<3>(rows, j.var, modes[k], warmup, reps, r); break;
+                case 16 : benchPuzzle<4>(rows, j.var, modes[k], warmup, reps, r); break;
+                case 25 : benchPuzzle<5>(rows, j.var, modes[k], warmup, reps, r); break;
+                case 36 : benchPuzzle<6>(rows, j.var, modes[k], warmup, reps, r); break;
+                default : break;
+            }
+
+            std::cout << " Bench " << " |  " << r.puzzle <<
+                      " | " << r.mode <<
+                      " | Median : " << r.median * 1e3 << " ms" <<
+                      " | P99 : " << r.p99 * 1e3 << " ms" <<
+                      " | Nodes : " << r.nodes <<
+                      " | Nodes/sec : " << ( r.median > 0 ? r.nodes / r.median : 0 ) <<
+                      " | Backtracked : " << r.backtracked <<
+                      ( r.solved ? "" : " | no solution" ) << std::endl;
+
+            modeTime[k] += r.median;
+            modeNodes[k] += r.nodes;
+            modeSolved[k] += r.solved ? 1 : 0;
+            results.push_back(r);
+        }
     }
 
-    std::cout << " Metrics " << " |  Nodes : " << m.iterations <<
-              " | Backtracked : " << m.backtracked <<
-              " | MaxStackHeight : " << m.maxStackHeight;
+    std::cout << std::endl;
+    for ( unsigned int k = 0; k < modes.size(); ++k ) {
+
+        std::cout << " Mode " << " |  " << modeName(modes[k]) <<
+                  " | Puzzles : " << puzzles <<
+                  " | Solved : " << modeSolved[k] <<
+                  " | Median total : " << modeTime[k] * 1e3 << " ms" <<
+                  " | Nodes/sec : " << ( modeTime[k] > 0 ? modeNodes[k] / modeTime[k] : 0 ) << std::endl;
+    }
+
+    if ( !csv.empty() && !writeCsv(csv, results) ) {
+
+        return 1;
+    }
+
+    if ( !json.empty() && !writeJson(json, results, warmup, reps) ) {
+
+        return 1;
+    }
+
+    return 0;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
 
-    // array storing the puzzle
-    char board[LEN][LEN];
-    int r = 0 ,c = 0;
-
-    // read the puzzle file into the board
-    std::ifstream ifs;
-    char value = '\0';
-//    ifs.open("worldsHardest.txt");
-    ifs.open("SudokuPuzzle7.txt");
-    if ( ifs.is_open() ) {
-
-        while ( ! ifs.eof() ) {
-            ifs.get(value);
-            if ( value == '\r' ) {
-                ifs.get(value);
-            }
-            if ( value == '\n' ) {
-                ++r;
-            } else {
-                board[r][c] = value;
-                ++c;
-                if ( c == LEN ) {
-                    c = 0;
-                    if ( r == LEN - 1) {
-                        break;
-                    }
-                }
+    // choose the engine, scan is the default
+    // unless solutions are counted, that wants the fastest search there is
+    options opt;
+    bool engineSet = false;
+    bool selectSet = false;
+    bool check = false;
+    std::string solName;
+    bool batch = false;
+    bool parallel = false;
+    int depth = 3;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    int generate = 0;
+    int sublen = 3;
+    int want = -1;
+    unsigned int seed = std::random_device()();
+    bool bench = false;
+    int warmup = 1;
+    int reps = 5;
+    std::string csv;
+    std::string json;
+    bool nameSet = false;
+    std::string name = "SudokuPuzzle7.txt";
+    for (int i = 1; i < argc; ++i) {
+
+        std::string arg = argv[i];
+        if ( arg.compare(0, 9, "--engine=") == 0 ) {
+            engineSet = true;
+        }
+
+        if ( arg == "--engine=scan" ) {
+            opt.e = SCAN;
+        } else if ( arg == "--engine=mask" ) {
+            opt.e = MASK;
+        } else if ( arg == "--engine=dlx" ) {
+            opt.e = DLX;
+        } else if ( arg == "--engine=iter" ) {
+            opt.e = ITER;
+        } else if ( arg == "--unique" ) {
+            opt.limit = 2;
+        } else if ( arg == "--verify" ) {
+            check = true;
+        } else if ( arg.compare(0, 9, "--verify=") == 0 ) {
+            check = true;
+            solName = arg.substr(9);
+        } else if ( arg.compare(0, 8, "--slice=") == 0 && std::atoll(arg.c_str() + 8) >= 0 ) {
+            opt.slice = std::atoll(arg.c_str() + 8);
+        } else if ( arg == "--select=first" ) {
+            opt.h = FIRST;
+            selectSet = true;
+        } else if ( arg == "--select=mrv" ) {
+            opt.h = MRV;
+            selectSet = true;
+        } else if ( arg == "--propagate" ) {
+            opt.rules = true;
+        } else if ( arg == "--batch" ) {
+            batch = true;
+        } else if ( arg == "--parallel" ) {
+            parallel = true;
+        } else if ( arg.compare(0, 8, "--split=") == 0 && std::atoi(arg.c_str() + 8) >= 0 ) {
+            depth = std::atoi(arg.c_str() + 8);
+        } else if ( arg.compare(0, 8, "--count=") == 0 && std::atoll(arg.c_str() + 8) >= 0 ) {
+            opt.limit = std::atoll(arg.c_str() + 8);
+        } else if ( arg.compare(0, 10, "--threads=") == 0 && std::atoi(arg.c_str() + 10) > 0 ) {
+            threads = std::atoi(arg.c_str() + 10);
+        } else if ( arg.compare(0, 11, "--generate=") == 0 && std::atoi(arg.c_str() + 11) > 0 ) {
+            generate = std::atoi(arg.c_str() + 11);
+        } else if ( arg.compare(0, 8, "--order=") == 0 && std::atoi(arg.c_str() + 8) >= 2 && std::atoi(arg.c_str() + 8) <= 6 ) {
+            sublen = std::atoi(arg.c_str() + 8);
+        } else if ( arg.compare(0, 7, "--seed=") == 0 ) {
+            seed = std::strtoul(arg.c_str() + 7, nullptr, 10);
+        } else if ( arg.compare(0, 8, "--grade=") == 0 &&
+                    std::find(GRADES, GRADES + GRADE_COUNT, arg.substr(8)) != GRADES + GRADE_COUNT ) {
+            want = std::find(GRADES, GRADES + GRADE_COUNT, arg.substr(8)) - GRADES;
+        } else if ( arg.compare(0, 9, "--kernel=") == 0 ) {
+            candidates = chooseKernel(arg.substr(9));
+            if ( candidates == nullptr ) {
+                std::cout << "this cpu can not run " << arg << std::endl;
+                return 1;
             }
+        } else if ( arg == "--bench" ) {
+            bench = true;
+        } else if ( arg.compare(0, 9, "--warmup=") == 0 && std::atoi(arg.c_str() + 9) >= 0 ) {
+            warmup = std::atoi(arg.c_str() + 9);
+        } else if ( arg.compare(0, 7, "--reps=") == 0 && std::atoi(arg.c_str() + 7) > 0 ) {
+            reps = std::atoi(arg.c_str() + 7);
+        } else if ( arg.compare(0, 6, "--csv=") == 0 ) {
+            csv = arg.substr(6);
+        } else if ( arg.compare(0, 7, "--json=") == 0 ) {
+            json = arg.substr(7);
+        } else if ( arg == "-" || arg.compare(0, 2, "--") != 0 ) {
+            name = arg;
+            nameSet = true;
+        } else {
+            std::cout << "usage: sudoku [--engine=scan|mask|dlx|iter [--slice=N]] [--select=first|mrv] [--propagate] [--kernel=avx2|sse4|scalar] [--count=N | --unique]" <<
+                      " [--verify[=solution file]] [--batch | --parallel [--split=D]] [--threads=N]" <<
+                      " [puzzle file | batch directory | batch file | -]" << std::endl <<
+                      "       sudoku --generate=N [--order=2..6] [--seed=S] [--grade=easy|medium|hard|evil|extreme] [--threads=N]" << std::endl <<
+                      "       sudoku --bench [--engine=... --select=... --propagate] [--count=N] [--warmup=N] [--reps=N]" <<
+                      " [--csv=file] [--json=file] [puzzle directory | batch file]" << std::endl;
+            return 1;
         }
-    } else {
-        std::cout << "error opening file.." << std::endl;
+    }
+
+    if ( generate > 0 ) {
+
+        return runGenerate(generate, sublen, seed, want, threads);
+    }
+
+    // only MASK and ITER choose the next cell, SCAN takes them in order and DLX has its own rule
+    bool selectIgnored = selectSet && opt.e != MASK && opt.e != ITER;
+    if ( bench && engineSet && selectIgnored ) {
+        std::cout << "--select needs --engine=mask or --engine=iter" << std::endl;
+        return 1;
+    }
+
+    if ( bench ) {
+
+        return runBench(nameSet ? name : ".", opt, !engineSet, warmup, reps, csv, json);
+    }
+
+    if ( opt.limit != 1 && !engineSet ) {
+        opt.e = ITER;
+        opt.h = MRV;
+        opt.rules = true;
+    }
+
+    if ( opt.rules && opt.e != MASK && opt.e != ITER ) {
+        std::cout << "--propagate needs --engine=mask or --engine=iter" << std::endl;
         return 1;
     }
-    ifs.close();
-    if ( ifs.is_open() ) {
-        std::cout << "error closing file.." << std::endl;
+
+    if ( selectIgnored && opt.e != MASK && opt.e != ITER ) {
+        std::cout << "--select needs --engine=mask or --engine=iter" << std::endl;
         return 1;
     }
 
-    // print the problem Sudoku Puzzle first
-    std::cout << std::endl << std::endl << "The Sudoku Puzzle" << std::endl << std::endl;
-    print(board);
+    if ( opt.limit != 1 && opt.e == SCAN ) {
+        std::cout << "--count needs --engine=mask, --engine=dlx or --engine=iter" << std::endl;
+        return 1;
+    }
 
-    // solve the puzzle
-    if ( work( board ) ) {
+    if ( parallel && ( batch || ( opt.e != MASK && opt.e != ITER ) ) ) {
+        std::cout << "--parallel needs --engine=mask or --engine=iter and no --batch" << std::endl;
+        return 1;
+    }
 
-        std::cout << std::endl << std::endl << "The Sudoku Puzzle Solution" << std::endl << std::endl;
+    if ( batch ) {
+
+        // without an engine on the command line the variants go to the iterative engine
+        options varOpt = opt;
+        if ( !engineSet ) {
+            varOpt.e = ITER;
+            varOpt.h = MRV;
+            varOpt.rules = true;
+        }
 
-        print( board );
+        return runBatch(name, opt, varOpt, threads, check);
     }
 
-}
+    // the order of the puzzle comes from the file, and so do the variants
+    std::vector<std::string> rows;
+    variant var;
+    if ( !readPuzzle(name, rows, &var) ) {
 
+        return 1;
+    }
+
+    if ( !var.empty() && !engineSet ) {
+        opt.e = ITER;
+        opt.h = MRV;
+        opt.rules = true;
+    }
+
+    if ( !var.empty() && opt.e != MASK && opt.e != ITER ) {
+        std::cout << "variants need --engine=mask or --engine=iter" << std::endl;
+        return 1;
+    }
+
+    if ( check && solName.empty() ) {
+        solName = solutionName(name);
+    }
+
+    if ( parallel ) {
+
+        switch ( rows.size() ) {
+            case 4 : return runParallel<2>(rows, var, opt, threads, depth, solName);
+            case 9 : return runParallel<3>(rows, var, opt, threads, depth, solName);
+            case 16 : return runParallel<4>(rows, var, opt, threads, depth, solName);
+            case 25 : return runParallel<5>(rows, var, opt, threads, depth, solName);
+            case 36 : return runParallel<6>(rows, var, opt, threads, depth, solName);
+            default : break;
+        }
+    }
+
+    switch ( rows.size() ) {
+        case 4 : return run<2>(rows, var, opt, solName);
+        case 9 : return run<3>(rows, var, opt, solName);
+        case 16 : return run<4>(rows, var, opt, solName);
+        case 25 : return run<5>(rows, var, opt, solName);
+        case 36 : return run<6>(rows, var, opt, solName);
+        default :
+            std::cout << name << " is " << rows.size() << "x" << rows.size() <<
+                      ", supported sizes are 4x4, 9x9, 16x16, 25x25 and 36x36" << std::endl;
+            return 1;
+    }
+}